@@ -6,8 +6,16 @@
 //  described in the README                               //
 //========================================================//
 
+#define _GNU_SOURCE
 #include "cache.h"
+#include "timing.h"
+#include "classify.h"
+#include "profile.h"
+#include "tlb.h"
+#include "dram.h"
 #include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
 
 //
 // TODO:Student Information
@@ -23,19 +31,37 @@ const char *email       = "rabboy@eng.ucsd.edu";
 uint32_t icacheSets;     // Number of sets in the I$
 uint32_t icacheAssoc;    // Associativity of the I$
 uint32_t icacheHitTime;  // Hit Time of the I$
+uint32_t icacheIndexFn;  // Set index function of the I$
 
 uint32_t dcacheSets;     // Number of sets in the D$
 uint32_t dcacheAssoc;    // Associativity of the D$
 uint32_t dcacheHitTime;  // Hit Time of the D$
+uint32_t dcacheIndexFn;  // Set index function of the D$
 
 uint32_t l2cacheSets;    // Number of sets in the L2$
 uint32_t l2cacheAssoc;   // Associativity of the L2$
 uint32_t l2cacheHitTime; // Hit Time of the L2$
+uint32_t l2cacheIndexFn; // Set index function of the L2$
 uint32_t inclusive;      // Indicates if the L2 is inclusive
+uint32_t l2cacheWayMask; // L2$ ways new lines may be placed in (0 for any)
 
 uint32_t blocksize;      // Block/Line size
+uint32_t icacheBlocksize;  // Line size of the I$ (0 to use blocksize)
+uint32_t dcacheBlocksize;  // Line size of the D$ (0 to use blocksize)
+uint32_t l2cacheBlocksize; // Line size of the L2$ (0 to use blocksize)
+uint32_t icacheSectorsize; // Sector size of the I$ (0 for unsectored lines)
+uint32_t dcacheSectorsize; // Sector size of the D$ (0 for unsectored lines)
+uint32_t l2cacheSectorsize;// Sector size of the L2$ (0 for unsectored lines)
 uint32_t memspeed;       // Latency of Main Memory
 
+uint32_t l1mshrs;        // MSHRs in each L1 (0 disables the timing model)
+uint32_t l2mshrs;        // MSHRs in the L2$
+uint32_t missWindow;     // Misses the core can have outstanding
+uint32_t hugepages;      // Back the cache arena with transparent huge pages
+uint32_t classify;       // Split misses into compulsory, capacity and conflict
+uint32_t profileTopK;    // Lines, regions and sets reported by the miss profiler
+uint32_t profileRegion;  // Size of an address region of the miss profiler
+
 //------------------------------------//
 //          Cache Statistics          //
 //------------------------------------//
@@ -51,30 +77,84 @@ uint64_t dcachePenalties;  // D$ penalties
 uint64_t l2cacheRefs;      // L2$ references
 uint64_t l2cacheMisses;    // L2$ misses
 uint64_t l2cachePenalties; // L2$ penalties
+uint64_t l2cacheOverlapped;// L2$ accesses sent alongside another of one L1 fill
+
+uint64_t icacheMerges;     // I$ misses merged into an in-flight MSHR
+uint64_t icacheMshrStalls; // I$ misses that waited for a free MSHR
+uint64_t dcacheMerges;     // D$ misses merged into an in-flight MSHR
+uint64_t dcacheMshrStalls; // D$ misses that waited for a free MSHR
+uint64_t l2cacheMerges;    // L2$ misses merged into an in-flight MSHR
+uint64_t l2cacheMshrStalls;// L2$ misses that waited for a free MSHR
+
+uint64_t icacheCompulsory; // I$ misses to blocks never referenced before
+uint64_t icacheCapacity;   // I$ misses a fully-associative cache also takes
+uint64_t icacheConflict;   // I$ misses a fully-associative cache would hit
+uint64_t dcacheCompulsory; // D$ misses to blocks never referenced before
+uint64_t dcacheCapacity;   // D$ misses a fully-associative cache also takes
+uint64_t dcacheConflict;   // D$ misses a fully-associative cache would hit
+uint64_t l2cacheCompulsory;// L2$ misses to blocks never referenced before
+uint64_t l2cacheCapacity;  // L2$ misses a fully-associative cache also takes
+uint64_t l2cacheConflict;  // L2$ misses a fully-associative cache would hit
 
 //------------------------------------//
 //        Cache Data Structures       //
 //------------------------------------//
 
 // Structures to build a cache
+//
+// The ways of every set are stored back to back in one array, set 'i'
+// starting at ways[i * assoc].  The lru field holds the LRU rank of the way
+// XORed with its way index, so a zero-filled set is a set in its reset state
+// (all invalid, way j at rank j) and sets never touched cost nothing.
+// The tag is the whole block address, so it does not depend on the index
+// function that placed the line.  The valid field holds one valid bit per
+// sector of the line, so an unsectored line is valid when it is 1 and a
+// line is present whenever any of its sectors is
+//
+// A skewed-associative cache has no sets: way j of a block lives in row
+// hash_j(block) of column j, and the lru field holds the cycle of the last
+// access instead of a rank
 struct way {
   uint32_t valid;
   uint32_t tag;
   uint32_t lru;
 };
 
-struct set {
-  struct way *ways;
+//Miss status holding register, one per line in flight
+struct mshr {
+  uint32_t block;   // Block address of the outstanding line
+  uint64_t ready;   // Cycle at which the line is filled
 };
 
 struct cache {
-  struct set* sets;
+  struct way *ways;
+  uint32_t assoc;
+  uint32_t indexFn;     // Set index function
+  uint32_t indexBits;   // Width of the set index
+  uint32_t indexMask;   // Mask of the set index
+  uint32_t folds;       // Index-width chunks of a block address, XOR-fold
+  uint32_t prime;       // Largest prime <= sets, prime-modulo
+  uint64_t primeMagic;  // 2^64 / prime rounded up, prime-modulo
+  uint32_t *skew;       // 4 byte tables for each way, skewed-associative
+  uint32_t clock;       // Access counter for the lru stamps, skewed-associative
+  uint32_t lineBits;    // Block offset bits of a line
+  uint32_t fillBits;    // Block offset bits of a sector, the unit of a fill
+  uint32_t sectors;     // Sectors in a line, at most 32
+  struct mshr *mshrs;
+  uint32_t mshrCount;
+  struct shadow shadow;
+  struct profile profile;
 };
 
 struct cache icache;
 struct cache dcache;
 struct cache l2cache;
 
+//Arena holding the ways and MSHRs of every cache level
+char *arena;
+size_t arenaSize;
+size_t arenaUsed;
+
 //Utilities
 //Loop variables
 int i,j;
@@ -88,6 +168,7 @@ int icacheIndexBits;
 int dcacheIndexBits;
 int l2cacheIndexBits;
 int blockOffsetBits;
+int profileRegionBits;
 
 //Current Index and Tag values
 uint32_t icacheIndex;
@@ -103,73 +184,50 @@ uint32_t l2cacheTag;
 //          Helper Functions          //
 //------------------------------------//
 
+//Function to get the cache structure of a cache type
+struct cache *getCache (char cacheType) {
+  switch(cacheType) {
+    case 'I': return &icache;
+    case 'D': return &dcache;
+    default:  return &l2cache;
+  }
+}
+
+//Function to get the ways of a set
+struct way *getSet (struct cache *c, uint32_t setIndex) {
+  return c->ways + (size_t)setIndex * c->assoc;
+}
+
+//Functions to read and write the LRU rank of way 'wayIndex' in a set
+uint32_t getLRU (struct way *ways, uint32_t wayIndex) {
+  return ways[wayIndex].lru ^ wayIndex;
+}
+
+void setLRU (struct way *ways, uint32_t wayIndex, uint32_t rank) {
+  ways[wayIndex].lru = rank ^ wayIndex;
+}
+
 //Function to get the next vacant way in a set, returns -1 if there is none
 int getVacantWayIndex (char cacheType, int setIndex) {
-  int wayIndex = -1;
-  struct set set_curr;
+  struct cache *c = getCache(cacheType);
+  struct way *ways = getSet(c, setIndex);
 
-  switch(cacheType) {
-    case 'I':
-      set_curr = icache.sets[setIndex];
-      //search for a vacant spot
-      for(j=0; j<icacheAssoc; j++) {
-        if(set_curr.ways[j].valid == 0) { return j; }
-      }
-      break;
-    case 'D':
-      set_curr = dcache.sets[setIndex];
-      //search for a vacant spot
-      for(j=0; j<dcacheAssoc; j++) {
-        if(set_curr.ways[j].valid == 0) { return j; }
-      }
-      break;
-    case 'L':
-      set_curr = l2cache.sets[setIndex];
-      //search for a vacant spot
-      for(j=0; j<l2cacheAssoc; j++) {
-        if(set_curr.ways[j].valid == 0) { return j; }
-      }
-      break;
-    default:
-      break;
+  //search for a vacant spot
+  for(j=0; j<c->assoc; j++) {
+    if(ways[j].valid == 0) { return j; }
   }
-  return wayIndex;
+  return -1;
 }
 
 //Function to get the LRU way index in a set
 int getLRUwayIndex (char cacheType, int setIndex) {
-  int wayIndex;
-  int lruCandidate;
-  struct set set_curr;
-
+  struct cache *c = getCache(cacheType);
+  struct way *ways = getSet(c, setIndex);
 
-  switch(cacheType) {
-    case 'I':
-      set_curr = icache.sets[setIndex];
-      //find the way which is LRU
-      lruCandidate = icacheAssoc - 1;
-      for(j=0; j<icacheAssoc; j++) {
-        if(set_curr.ways[j].lru == lruCandidate) { return j; }
-      }
-      break;
-    case 'D':
-      set_curr = dcache.sets[setIndex];
-      //find the way which is LRU
-      lruCandidate = dcacheAssoc - 1;
-      for(j=0; j<dcacheAssoc; j++) {
-        if(set_curr.ways[j].lru == lruCandidate) { return j; }
-      }
-      break;
-    case 'L':
-      set_curr = l2cache.sets[setIndex];
-      //find the way which is LRU
-      lruCandidate = l2cacheAssoc - 1;
-      for(j=0; j<l2cacheAssoc; j++) {
-        if(set_curr.ways[j].lru == lruCandidate) { return j; }
-      }
-      break;
-    default:
-      break;
+  //find the way which is LRU
+  uint32_t lruCandidate = c->assoc - 1;
+  for(j=0; j<c->assoc; j++) {
+    if(getLRU(ways, j) == lruCandidate) { return j; }
   }
   return 0;
 }
@@ -186,51 +244,276 @@ int getWayIndex (char cacheType, int setIndex) {
   return wayIndex;
 }
 
+//Function to get the candidate way for replacement among the ways in 'mask',
+//a vacant one if there is any and the LRU one otherwise
+int getMaskedWayIndex (char cacheType, int setIndex, uint32_t mask) {
+  struct cache *c = getCache(cacheType);
+  struct way *ways = getSet(c, setIndex);
+  int wayIndex = 0;
+  uint32_t oldest = 0;
+
+  for(j=0; j<c->assoc && j<32; j++) {
+    if(!(mask & (1u << j))) { continue; }
+    if(ways[j].valid == 0) { return j; }
+    if(getLRU(ways, j) >= oldest) {
+      oldest = getLRU(ways, j);
+      wayIndex = j;
+    }
+  }
+  return wayIndex;
+}
+
 //Function to access wayIndex, thereby updating the LRU values in a set
 void accessAndUpdateLRU (char cacheType, int setIndex, int wayIndex) {
-  struct set set_curr;
-  struct way way_curr;
-  int oldLru;
+  struct cache *c = getCache(cacheType);
+  struct way *ways = getSet(c, setIndex);
+  uint32_t oldLru = getLRU(ways, wayIndex);
+
+  for(j=0; j<c->assoc; j++) {
+    if(j==wayIndex) { setLRU(ways, j, 0); continue; }
+    uint32_t lru = getLRU(ways, j);
+    if(lru < oldLru) { setLRU(ways, j, lru + 1); }
+  }
+}
+
+//Function to get the row of 'block' in way 'wayIndex' of a skewed cache.
+//Each way has its own H3 hash, the XOR of one random entry per byte of the
+//block address
+uint32_t getSkewIndex (struct cache *c, uint32_t block, uint32_t wayIndex) {
+  const uint32_t *t = c->skew + (size_t)wayIndex * 1024;
+  return (t[block & 0xff] ^ t[256 + ((block >> 8) & 0xff)] ^
+          t[512 + ((block >> 16) & 0xff)] ^ t[768 + (block >> 24)]) & c->indexMask;
+}
+
+//Function to get the set 'block' maps to, for a skewed cache its row in way 0
+uint32_t getSetIndex (struct cache *c, uint32_t block) {
+  uint32_t index, fold;
+  uint64_t frac;
+
+  switch(c->indexFn) {
+    case INDEX_XOR:
+      index = 0;
+      for(fold=0; fold<c->folds; fold++) {
+        index ^= block;
+        block >>= c->indexBits;
+      }
+      return index & c->indexMask;
+    case INDEX_PRIME:
+      //The low 64 bits of block * 2^64/prime are the fraction of
+      //block/prime, the top 32 bits of fraction * prime the remainder
+      frac = c->primeMagic * block;
+      return (uint32_t)(((frac >> 32) * c->prime +
+                         (((frac & 0xffffffff) * c->prime) >> 32)) >> 32);
+    case INDEX_SKEW:
+      return getSkewIndex(c, block, 0);
+    default:
+      return block & c->indexMask;
+  }
+}
+
+//Function to find 'block' in a cache. On a hit the line is returned with its
+//set and way, on a miss NULL is returned and *setIndex holds the set it maps to
+struct way *lookupLine (char cacheType, uint32_t block, uint32_t *setIndex, uint32_t *wayIndex) {
+  struct cache *c = getCache(cacheType);
+  uint32_t w;
+
+  if(c->indexFn == INDEX_SKEW) {
+    for(w=0; w<c->assoc; w++) {
+      uint32_t row = getSkewIndex(c, block, w);
+      struct way *line = getSet(c, row) + w;
+      if(line->valid && line->tag == block) {
+        *setIndex = row;
+        *wayIndex = w;
+        return line;
+      }
+    }
+    *setIndex = getSkewIndex(c, block, 0);
+    return NULL;
+  }
+
+  *setIndex = getSetIndex(c, block);
+  struct way *ways = getSet(c, *setIndex);
+  for(w=0; w<c->assoc; w++) {
+    if(ways[w].valid && ways[w].tag == block) {
+      *wayIndex = w;
+      return &ways[w];
+    }
+  }
+  return NULL;
+}
+
+//Function to get the line 'block' replaces. A skewed cache takes the first
+//vacant candidate line, or else the one accessed longest ago. L2$ lines
+//only replace the ways of l2cacheWayMask, when it is set
+struct way *victimLine (char cacheType, uint32_t block, uint32_t *setIndex, uint32_t *wayIndex) {
+  struct cache *c = getCache(cacheType);
+  uint32_t mask = (cacheType == 'L') ? l2cacheWayMask : 0;
+
+  if(c->indexFn == INDEX_SKEW) {
+    struct way *victim = NULL;
+    uint32_t w;
+    for(w=0; w<c->assoc; w++) {
+      if(mask && (w >= 32 || !(mask & (1u << w)))) { continue; }
+      uint32_t row = getSkewIndex(c, block, w);
+      struct way *line = getSet(c, row) + w;
+      if(victim == NULL || !line->valid || (int32_t)(line->lru - victim->lru) < 0) {
+        victim = line;
+        *setIndex = row;
+        *wayIndex = w;
+        if(!line->valid) { break; }
+      }
+    }
+    return victim;
+  }
+
+  *setIndex = getSetIndex(c, block);
+  *wayIndex = mask ? getMaskedWayIndex(cacheType, *setIndex, mask) : getWayIndex(cacheType, *setIndex);
+  return getSet(c, *setIndex) + *wayIndex;
+}
+
+//Function to mark a line as the most recently used
+void touchLine (char cacheType, uint32_t setIndex, uint32_t wayIndex) {
+  struct cache *c = getCache(cacheType);
+  if(c->indexFn == INDEX_SKEW) {
+    getSet(c, setIndex)[wayIndex].lru = ++c->clock;
+    return;
+  }
+  accessAndUpdateLRU(cacheType, setIndex, wayIndex);
+}
+
+//Function to get the valid bit of the sector holding byte 'addr'
+uint32_t getSectorBit (struct cache *c, uint32_t addr) {
+  return 1u << ((addr >> c->fillBits) & (c->sectors - 1));
+}
+
+//Function to invalidate the bytes [base, base+bytes) in a cache. Every
+//sector they overlap is dropped, and a line left with no sector is free
+void invalidateRange (char cacheType, uint32_t base, uint32_t bytes) {
+  struct cache *c = getCache(cacheType);
+  uint32_t last = base + (bytes - 1);
+  uint32_t block, setIndex, wayIndex;
+
+  for(block=base>>c->lineBits; ; block++) {
+    struct way *line = lookupLine(cacheType, block, &setIndex, &wayIndex);
+    if(line) {
+      uint32_t lineBase = block << c->lineBits;
+      uint32_t lineLast = lineBase + ((1u << c->lineBits) - 1);
+      uint32_t first = ((base > lineBase ? base : lineBase) - lineBase) >> c->fillBits;
+      uint32_t end = ((last < lineLast ? last : lineLast) - lineBase) >> c->fillBits;
+      //Bits first..end of the sector mask
+      uint32_t mask = (uint32_t)((UINT64_C(2) << end) - (UINT64_C(1) << first));
+      line->valid &= ~mask;
+    }
+    if(block == last >> c->lineBits) { break; }
+  }
+}
+
+//Function to fetch the 'bytes' bytes around 'addr' from the L2$ for an L1
+//fill. They take one L2$ access per L2$ sector they span, all sent at once,
+//so the fill takes as long as the slowest of them
+uint32_t l2cacheFill (uint32_t addr, uint32_t bytes) {
+  uint32_t unit = 1u << l2cache.fillBits;
+  if(!l2Valid || bytes <= unit) { return l2cache_access(addr); }
+
+  uint32_t base = addr & ~(bytes - 1);
+  uint32_t penalty = 0;
+  uint64_t ready = 0;
+  uint32_t n;
+  l2cacheOverlapped += bytes/unit - 1;
+  for(n=0; n<bytes/unit; n++) {
+    uint32_t time = l2cache_access(base + n * unit);
+    if(time > penalty) { penalty = time; }
+    if(timingReady > ready) { ready = timingReady; }
+  }
+  timingReady = ready;
+  return penalty;
+}
+
+//Function to fetch the line at 'addr' from main memory, returns the latency.
+//With 'ready' the fetch issues at cycle *ready, which receives the cycle at
+//which it completes
+uint32_t memoryAccess (uint32_t addr, uint64_t *ready) {
+  if(dramChannels) { return dram_access(addr, ready); }
+  if(ready) { *ready += memspeed; }
+  return memspeed;
+}
+
+//Function to classify an access to 'block' and count its miss, if any
+void classifyAccess (char cacheType, uint32_t block, int miss) {
+  int kind = shadow_access(&getCache(cacheType)->shadow, block, miss);
+  if(kind == MISS_NONE) { return; }
 
   switch(cacheType) {
     case 'I':
-      // printf("I cache LRU update.\n");
-      set_curr = icache.sets[setIndex];
-      way_curr = set_curr.ways[wayIndex];
-      oldLru = way_curr.lru;
-
-      for(j=0; j<icacheAssoc; j++) {
-        if(j==wayIndex) {icache.sets[setIndex].ways[j].lru = 0; continue; }
-        if(icache.sets[setIndex].ways[j].lru < oldLru) { icache.sets[setIndex].ways[j].lru++; }
-      }
+      if(kind == MISS_COMPULSORY) { icacheCompulsory++; }
+      else if(kind == MISS_CAPACITY) { icacheCapacity++; }
+      else { icacheConflict++; }
       break;
     case 'D':
-      // printf("D cache LRU update.\n");
-      set_curr = dcache.sets[setIndex];
-      way_curr = set_curr.ways[wayIndex];
-      oldLru = way_curr.lru;
-
-      for(j=0; j<dcacheAssoc; j++) {
-        if(j==wayIndex) {dcache.sets[setIndex].ways[j].lru = 0; continue; }
-        if(dcache.sets[setIndex].ways[j].lru < oldLru) { dcache.sets[setIndex].ways[j].lru++; }
-      }
+      if(kind == MISS_COMPULSORY) { dcacheCompulsory++; }
+      else if(kind == MISS_CAPACITY) { dcacheCapacity++; }
+      else { dcacheConflict++; }
       break;
     case 'L':
-      // printf("L2 cache LRU update.\n");
-      set_curr = l2cache.sets[setIndex];
-      way_curr = set_curr.ways[wayIndex];
-      oldLru = way_curr.lru;
-
-      for(j=0; j<l2cacheAssoc; j++) {
-        if(j==wayIndex) {l2cache.sets[setIndex].ways[j].lru = 0; continue; }
-        if(l2cache.sets[setIndex].ways[j].lru < oldLru) { l2cache.sets[setIndex].ways[j].lru++; }
-      }
+      if(kind == MISS_COMPULSORY) { l2cacheCompulsory++; }
+      else if(kind == MISS_CAPACITY) { l2cacheCapacity++; }
+      else { l2cacheConflict++; }
       break;
     default:
       break;
   }
 }
 
+//Function to record the line in 'victim' being replaced in set 'setIndex'
+void profileEviction (char cacheType, uint32_t setIndex, struct way *victim) {
+  if(!victim->valid) { return; }
+  profile_evict(&getCache(cacheType)->profile, victim->tag, setIndex);
+}
+
+//Function to carve 'bytes' out of the cache arena
+void *arenaAlloc (size_t bytes) {
+  void *ptr = arena + arenaUsed;
+  //Keep every allocation cache line aligned
+  arenaUsed += (bytes + 63) & ~(size_t)63;
+  return ptr;
+}
+
+//Function to find an in-flight miss to 'block', returns NULL if there is none
+struct mshr *findMSHR (struct cache *c, uint32_t block, uint64_t now) {
+  uint32_t k;
+  for(k=0; k<c->mshrCount; k++) {
+    if(c->mshrs[k].ready > now && c->mshrs[k].block == block) { return &c->mshrs[k]; }
+  }
+  return NULL;
+}
+
+//Function to claim an MSHR for a miss at cycle *now. If every MSHR is busy
+//the miss waits for the earliest one to free up and *now is pushed forward
+struct mshr *allocMSHR (struct cache *c, uint64_t *now, uint64_t *stalls) {
+  struct mshr *m = &c->mshrs[0];
+  uint32_t k;
+  for(k=1; k<c->mshrCount; k++) {
+    if(c->mshrs[k].ready < m->ready) { m = &c->mshrs[k]; }
+  }
+  if(m->ready > *now) {
+    (*stalls)++;
+    *now = m->ready;
+  }
+  return m;
+}
+
+//Function to allocate the MSHR file of a cache
+void initMSHRs (struct cache *c, uint32_t count) {
+  c->mshrCount = count;
+  c->mshrs = arenaAlloc(count * sizeof(struct mshr));
+}
+
+//Function to lay out the ways of a cache in the arena
+void initWays (struct cache *c, uint32_t sets, uint32_t assoc) {
+  c->assoc = assoc;
+  c->ways = arenaAlloc((size_t)sets * assoc * sizeof(struct way));
+}
+
 //Functions to print out the contents of a cache
 void print_icache() {
   if(!iValid) { return; }
@@ -238,12 +521,12 @@ void print_icache() {
   //print out cache contents
   for(i=0; i<icacheSets; i++) {
     //each set on a line
-    struct set set_curr = icache.sets[i];
+    struct way *ways = getSet(&icache, i);
     printf("Set %d: ----> ", i);
     //print set's contents
     for(j=0; j<icacheAssoc; j++) {
-      struct way way_curr = set_curr.ways[j];
-      printf("| V:%d Tag:%d lru:%d |", way_curr.valid, way_curr.tag, way_curr.lru);
+      struct way way_curr = ways[j];
+      printf("| V:%d Tag:%d lru:%d |", way_curr.valid, way_curr.tag, getLRU(ways, j));
     }
     printf("\n");
   }
@@ -256,12 +539,12 @@ void print_dcache() {
   //print out cache contents
   for(i=0; i<dcacheSets; i++) {
     //each set on a line
-    struct set set_curr = dcache.sets[i];
+    struct way *ways = getSet(&dcache, i);
     printf("Set %d: ----> ", i);
     //print set's contents
     for(j=0; j<dcacheAssoc; j++) {
-      struct way way_curr = set_curr.ways[j];
-      printf("| V:%d Tag:%d lru:%d |", way_curr.valid, way_curr.tag, way_curr.lru);
+      struct way way_curr = ways[j];
+      printf("| V:%d Tag:%d lru:%d |", way_curr.valid, way_curr.tag, getLRU(ways, j));
     }
     printf("\n");
   }
@@ -274,12 +557,12 @@ void print_l2cache() {
   //print out cache contents
   for(i=0; i<l2cacheSets; i++) {
     //each set on a line
-    struct set set_curr = l2cache.sets[i];
+    struct way *ways = getSet(&l2cache, i);
     printf("Set %d: ----> ", i);
     //print set's contents
     for(j=0; j<l2cacheAssoc; j++) {
-      struct way way_curr = set_curr.ways[j];
-      printf("| V:%d Tag:%d lru:%d |", way_curr.valid, way_curr.tag, way_curr.lru);
+      struct way way_curr = ways[j];
+      printf("| V:%d Tag:%d lru:%d |", way_curr.valid, way_curr.tag, getLRU(ways, j));
     }
     printf("\n");
   }
@@ -306,6 +589,57 @@ int power(int x, int n) {
   return result;
 }
 
+//Function to set up the line and sector sizes of a cache. Sectors are
+//limited to 32 a line, the width of the valid field
+void initLines (struct cache *c, uint32_t lineSize, uint32_t sectorSize) {
+  c->lineBits = intLog2(lineSize ? lineSize : blocksize);
+  c->fillBits = (sectorSize && intLog2(sectorSize) < c->lineBits) ? intLog2(sectorSize) : c->lineBits;
+  if(c->lineBits - c->fillBits > 5) { c->fillBits = c->lineBits - 5; }
+  c->sectors = 1u << (c->lineBits - c->fillBits);
+}
+
+//Function to check the index function of a level before anything is built
+void checkIndex (const char *name, uint32_t sets, uint32_t indexFn) {
+  if(!index_supports_sets(indexFn, sets)) {
+    fprintf(stderr, "%s has %u sets, only the prime index takes a count that is "
+                    "not a power of two\n", name, sets);
+    exit(1);
+  }
+}
+
+//Function to set up the index function of a cache. The skew tables come
+//from a fixed seed so that runs are reproducible
+void initIndex (struct cache *c, uint32_t sets, uint32_t indexFn, uint32_t seed) {
+  uint32_t n;
+  c->indexFn = indexFn;
+  c->indexBits = intLog2(sets);
+  c->indexMask = (1u << c->indexBits) - 1;
+  c->clock = 0;
+  c->skew = NULL;
+
+  //Chunks of the block address folded onto the index
+  c->folds = c->indexBits ? (32 - c->lineBits + c->indexBits - 1) / c->indexBits : 0;
+
+  //Largest prime that does not exceed the number of sets
+  c->prime = sets;
+  while(c->prime > 2) {
+    for(n=2; n*n<=c->prime && c->prime%n; n++);
+    if(n*n > c->prime) { break; }
+    c->prime--;
+  }
+  c->primeMagic = UINT64_C(0xFFFFFFFFFFFFFFFF) / c->prime + 1;
+
+  if(indexFn == INDEX_SKEW) {
+    c->skew = arenaAlloc((size_t)c->assoc * 1024 * sizeof(uint32_t));
+    for(n=0; n<c->assoc*1024; n++) {
+      seed ^= seed << 13;
+      seed ^= seed >> 17;
+      seed ^= seed << 5;
+      c->skew[n] = seed;
+    }
+  }
+}
+
 //------------------------------------//
 //          Cache Functions           //
 //------------------------------------//
@@ -324,6 +658,22 @@ void init_cache()
   l2cacheRefs       = 0;
   l2cacheMisses     = 0;
   l2cachePenalties  = 0;
+  l2cacheOverlapped = 0;
+  icacheMerges      = 0;
+  icacheMshrStalls  = 0;
+  dcacheMerges      = 0;
+  dcacheMshrStalls  = 0;
+  l2cacheMerges     = 0;
+  l2cacheMshrStalls = 0;
+  icacheCompulsory  = 0;
+  icacheCapacity    = 0;
+  icacheConflict    = 0;
+  dcacheCompulsory  = 0;
+  dcacheCapacity    = 0;
+  dcacheConflict    = 0;
+  l2cacheCompulsory = 0;
+  l2cacheCapacity   = 0;
+  l2cacheConflict   = 0;
 
   //Initialize cache by allocating memory
   // printf("init_cache called.\n");
@@ -334,6 +684,12 @@ void init_cache()
 
   // printf("Validity Flags - i:d:l2 = %d:%d:%d\n", iValid, dValid, l2Valid);
 
+  //The other index functions mask the block address, and would run past
+  //the last set of a count that is not a power of two
+  if(iValid) { checkIndex("I-cache", icacheSets, icacheIndexFn); }
+  if(dValid) { checkIndex("D-cache", dcacheSets, dcacheIndexFn); }
+  if(l2Valid) { checkIndex("L2-cache", l2cacheSets, l2cacheIndexFn); }
+
   //Calculate the number of bits for Index and BlockOffset
   icacheIndexBits = intLog2(icacheSets);
   dcacheIndexBits = intLog2(dcacheSets);
@@ -343,56 +699,96 @@ void init_cache()
   // printf("Index Bits: I:%d, D:%d, L2:%d, #BlockOffset: %d\n", icacheIndexBits, dcacheIndexBits, l2cacheIndexBits, blockOffsetBits);
 
   //----------------------------------------------------------------------
-  //Create icache
+  //Size the arena holding every level, so that the whole hierarchy is a
+  //single mapping. The kernel hands out zero pages on first touch, which
+  //is exactly the reset state of a set, so nothing is initialised here
+  if(l1mshrs) {
+    if(l2mshrs == 0) { l2mshrs = l1mshrs; }
+    if(missWindow == 0) { missWindow = l1mshrs; }
+  }
+
+  arenaSize = 0;
   if(iValid) {
-    //Create an array of sets
-    icache.sets = malloc(icacheSets * sizeof(struct set));
-    //Initialize all sets to default values
-    for(i=0; i<icacheSets; i++) {
-      icache.sets[i].ways = malloc(icacheAssoc * sizeof(struct way));
-      //Initialize each way with default values
-      for(j=0; j<icacheAssoc; j++) {
-        icache.sets[i].ways[j].valid = 0;
-        icache.sets[i].ways[j].tag = 0;
-        icache.sets[i].ways[j].lru = j;
-      }
+    arenaSize += (size_t)icacheSets * icacheAssoc * sizeof(struct way) + 64;
+    arenaSize += l1mshrs * sizeof(struct mshr) + 64;
+    if(icacheIndexFn == INDEX_SKEW) { arenaSize += (size_t)icacheAssoc * 1024 * sizeof(uint32_t) + 64; }
+  }
+  if(dValid) {
+    arenaSize += (size_t)dcacheSets * dcacheAssoc * sizeof(struct way) + 64;
+    arenaSize += l1mshrs * sizeof(struct mshr) + 64;
+    if(dcacheIndexFn == INDEX_SKEW) { arenaSize += (size_t)dcacheAssoc * 1024 * sizeof(uint32_t) + 64; }
+  }
+  if(l2Valid) {
+    arenaSize += (size_t)l2cacheSets * l2cacheAssoc * sizeof(struct way) + 64;
+    arenaSize += l2mshrs * sizeof(struct mshr) + 64;
+    if(l2cacheIndexFn == INDEX_SKEW) { arenaSize += (size_t)l2cacheAssoc * 1024 * sizeof(uint32_t) + 64; }
+  }
+
+  arena = NULL;
+  arenaUsed = 0;
+  if(arenaSize) {
+    arena = mmap(NULL, arenaSize, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(arena == MAP_FAILED) {
+      fprintf(stderr, "Unable to map %zu bytes for the caches\n", arenaSize);
+      exit(1);
     }
+#ifdef MADV_HUGEPAGE
+    if(hugepages) { madvise(arena, arenaSize, MADV_HUGEPAGE); }
+#endif
   }
+
+  if(iValid) { initWays(&icache, icacheSets, icacheAssoc); }
+  if(dValid) { initWays(&dcache, dcacheSets, dcacheAssoc); }
+  if(l2Valid) { initWays(&l2cache, l2cacheSets, l2cacheAssoc); }
   //----------------------------------------------------------------------
 
   //----------------------------------------------------------------------
-  //Create dcache
-  if(dValid) {
-    //Create an array of sets
-    dcache.sets = malloc(dcacheSets * sizeof(struct set));
-    //Initialize all sets to default values
-    for(i=0; i<dcacheSets; i++) {
-      dcache.sets[i].ways = malloc(dcacheAssoc * sizeof(struct way));
-      //Initialize each way with default values
-      for(j=0; j<dcacheAssoc; j++) {
-        dcache.sets[i].ways[j].valid = 0;
-        dcache.sets[i].ways[j].tag = 0;
-        dcache.sets[i].ways[j].lru = j;
-      }
-    }
+  //Precompute the line geometry and set index function of each level
+  if(iValid) { initLines(&icache, icacheBlocksize, icacheSectorsize); }
+  if(dValid) { initLines(&dcache, dcacheBlocksize, dcacheSectorsize); }
+  if(l2Valid) { initLines(&l2cache, l2cacheBlocksize, l2cacheSectorsize); }
+  if(iValid) { initIndex(&icache, icacheSets, icacheIndexFn, 0x9e3779b9); }
+  if(dValid) { initIndex(&dcache, dcacheSets, dcacheIndexFn, 0x85ebca6b); }
+  if(l2Valid) { initIndex(&l2cache, l2cacheSets, l2cacheIndexFn, 0xc2b2ae35); }
+  //----------------------------------------------------------------------
+
+  //----------------------------------------------------------------------
+  //Create the MSHR files and the core clock for the timing model
+  if(l1mshrs) {
+    if(iValid) { initMSHRs(&icache, l1mshrs); }
+    if(dValid) { initMSHRs(&dcache, l1mshrs); }
+    if(l2Valid) { initMSHRs(&l2cache, l2mshrs); }
+    init_timing();
   }
   //----------------------------------------------------------------------
 
   //----------------------------------------------------------------------
-  //Create l2cache
-  if(l2Valid) {
-    //Create an array of sets
-    l2cache.sets = malloc(l2cacheSets * sizeof(struct set));
-    //Initialize all sets to default values
-    for(i=0; i<l2cacheSets; i++) {
-      l2cache.sets[i].ways = malloc(l2cacheAssoc * sizeof(struct way));
-      //Initialize each way with default values
-      for(j=0; j<l2cacheAssoc; j++) {
-        l2cache.sets[i].ways[j].valid = 0;
-        l2cache.sets[i].ways[j].tag = 0;
-        l2cache.sets[i].ways[j].lru = j;
-      }
-    }
+  //Create the shadow caches that classify the misses of each level
+  if(classify) {
+    if(iValid) { shadow_init(&icache.shadow, icacheSets * icacheAssoc * icache.sectors); }
+    if(dValid) { shadow_init(&dcache.shadow, dcacheSets * dcacheAssoc * dcache.sectors); }
+    if(l2Valid) { shadow_init(&l2cache.shadow, l2cacheSets * l2cacheAssoc * l2cache.sectors); }
+  }
+  //----------------------------------------------------------------------
+
+  //----------------------------------------------------------------------
+  //Create the TLBs that translate the addresses of the trace
+  init_tlb();
+  //----------------------------------------------------------------------
+
+  //----------------------------------------------------------------------
+  //Create the banks of the DRAM model
+  init_dram();
+  //----------------------------------------------------------------------
+
+  //----------------------------------------------------------------------
+  //Create the miss profilers
+  if(profileTopK) {
+    profileRegionBits = intLog2(profileRegion);
+    if(iValid) { profile_init(&icache.profile, icacheSets, profileTopK); }
+    if(dValid) { profile_init(&dcache.profile, dcacheSets, profileTopK); }
+    if(l2Valid) { profile_init(&l2cache.profile, l2cacheSets, profileTopK); }
   }
   //----------------------------------------------------------------------
 
@@ -406,6 +802,64 @@ void init_cache()
   // printf("LRU way index for D cache at set 11: %d\n", getLRUwayIndex('D', 11));
 }
 
+// Check that a level of 'sets' sets can use the set index function 'indexFn'
+//
+int index_supports_sets(uint32_t indexFn, uint32_t sets)
+{
+  return indexFn == INDEX_PRIME || (sets & (sets - 1)) == 0;
+}
+
+// Release the memory held by the cache hierarchy
+//
+void free_cache()
+{
+  if(arena) { munmap(arena, arenaSize); }
+  arena = NULL;
+  arenaSize = 0;
+  arenaUsed = 0;
+
+  icache.ways = dcache.ways = l2cache.ways = NULL;
+  icache.mshrs = dcache.mshrs = l2cache.mshrs = NULL;
+  icache.mshrCount = dcache.mshrCount = l2cache.mshrCount = 0;
+  icache.skew = dcache.skew = l2cache.skew = NULL;
+  icache.indexFn = dcache.indexFn = l2cache.indexFn = INDEX_MODULO;
+
+  if(l1mshrs) { free_timing(); }
+  free_tlb();
+  free_dram();
+  if(icache.shadow.nodes) { shadow_free(&icache.shadow); }
+  if(dcache.shadow.nodes) { shadow_free(&dcache.shadow); }
+  if(l2cache.shadow.nodes) { shadow_free(&l2cache.shadow); }
+  if(icache.profile.setEvictions) { profile_free(&icache.profile); }
+  if(dcache.profile.setEvictions) { profile_free(&dcache.profile); }
+  if(l2cache.profile.setEvictions) { profile_free(&l2cache.profile); }
+}
+
+// Invalidate every line of the I$ and D$
+//
+void flush_l1()
+{
+  //A zero-filled set is a set in its reset state
+  if(iValid) { memset(icache.ways, 0, (size_t)icacheSets * icacheAssoc * sizeof(struct way)); }
+  if(dValid) { memset(dcache.ways, 0, (size_t)dcacheSets * dcacheAssoc * sizeof(struct way)); }
+}
+
+// Print the misses and evictions attributed by the miss profiler
+//
+void print_profile()
+{
+  printf("Miss Profile:\n");
+  if(iValid) {
+    profile_print(&icache.profile, "I-cache", profileTopK, icache.lineBits, profileRegionBits);
+  }
+  if(dValid) {
+    profile_print(&dcache.profile, "D-cache", profileTopK, dcache.lineBits, profileRegionBits);
+  }
+  if(l2Valid) {
+    profile_print(&l2cache.profile, "L2-cache", profileTopK, l2cache.lineBits, profileRegionBits);
+  }
+}
+
 // Perform a memory access through the icache interface for the address 'addr'
 // Return the access time for the memory operation
 //
@@ -425,34 +879,58 @@ uint32_t icache_access(uint32_t addr)
   //Calculate index, tag
   uint32_t address = addr;
 
-  //remove the block offset bits
-  address = address >> blockOffsetBits;
-  icacheIndex = (icacheIndexBits == 0)? 0 : address % power(2,icacheIndexBits);
-  icacheTag = address / power(2,icacheIndexBits);
-
-  // printf("Index: %d, Tag: %d\n", icacheIndex, icacheTag);
-
-  //Check for a hit
-  struct set set_curr = icache.sets[icacheIndex];
-  for(j=0; j<icacheAssoc; j++) {
-    struct way way_curr = set_curr.ways[j];
-    if(way_curr.valid && way_curr.tag == icacheTag) {
-      accessAndUpdateLRU('I', icacheIndex, j);
-      return icacheHitTime;
+  //remove the block offset bits, the rest is the tag
+  address = address >> icache.lineBits;
+  icacheTag = address;
+  uint32_t sector = getSectorBit(&icache, addr);
+
+  //Check for a hit, the line must be present and hold the sector
+  uint32_t wayIndex;
+  struct way *line = lookupLine('I', address, &icacheIndex, &wayIndex);
+  if(line && (line->valid & sector)) {
+    touchLine('I', icacheIndex, wayIndex);
+    if(classify) { classifyAccess('I', addr >> icache.fillBits, FALSE); }
+    if(l1mshrs) {
+      //A hit on a line still being filled waits for the fill
+      timingReady = timingNow + icacheHitTime;
+      struct mshr *m = findMSHR(&icache, address, timingNow);
+      if(m) {
+        icacheMerges++;
+        if(m->ready > timingReady) { timingReady = m->ready; }
+      }
     }
+    return icacheHitTime;
   }
 
   //Miss, so handle it appropriately
   icacheMisses++;
-  uint32_t icacheMissPenalty = l2cache_access(addr);
+  if(classify) { classifyAccess('I', addr >> icache.fillBits, TRUE); }
+  if(profileTopK) { profile_miss(&icache.profile, address, addr >> profileRegionBits); }
+  struct mshr *icacheMshr = NULL;
+  if(l1mshrs) {
+    //The miss is known after the tag check and needs an MSHR to go out
+    timingNow += icacheHitTime;
+    icacheMshr = allocMSHR(&icache, &timingNow, &icacheMshrStalls);
+  }
+  uint32_t icacheMissPenalty = l2cacheFill(addr, 1u << icache.fillBits);
+  if(icacheMshr) {
+    icacheMshr->block = address;
+    icacheMshr->ready = timingReady;
+  }
   icachePenalties += icacheMissPenalty;
   icacheAccessTime = icacheHitTime + icacheMissPenalty;
 
-  //Add hit time to access time
-  int wayIndex = getWayIndex('I', icacheIndex);
-  icache.sets[icacheIndex].ways[wayIndex].valid = 1;
-  icache.sets[icacheIndex].ways[wayIndex].tag = icacheTag;
-  accessAndUpdateLRU('I', icacheIndex, wayIndex);
+  //A line that is present only lacks the sector, otherwise fill the line
+  //chosen for replacement
+  if(line && line->valid) {
+    line->valid |= sector;
+  } else {
+    line = victimLine('I', address, &icacheIndex, &wayIndex);
+    if(profileTopK) { profileEviction('I', icacheIndex, line); }
+    line->valid = sector;
+    line->tag = icacheTag;
+  }
+  touchLine('I', icacheIndex, wayIndex);
   //TODO: Update icacheStatistics before returning
   //remove
   // print_icache();
@@ -478,34 +956,58 @@ uint32_t dcache_access(uint32_t addr)
   //Calculate index, tag
   uint32_t address = addr;
 
-  //remove the block offset bits
-  address = address >> blockOffsetBits;
-  dcacheIndex = (dcacheIndexBits == 0)? 0 : address % power(2,dcacheIndexBits);
-  dcacheTag = address / power(2,dcacheIndexBits);
-
-  // printf("Index: %d, Tag: %d\n", dcacheIndex, dcacheTag);
-
-  //Check for a hit
-  struct set set_curr = dcache.sets[dcacheIndex];
-  for(j=0; j<dcacheAssoc; j++) {
-    struct way way_curr = set_curr.ways[j];
-    if(way_curr.valid && way_curr.tag == dcacheTag) {
-      accessAndUpdateLRU('D', dcacheIndex, j);
-      return dcacheHitTime;
+  //remove the block offset bits, the rest is the tag
+  address = address >> dcache.lineBits;
+  dcacheTag = address;
+  uint32_t sector = getSectorBit(&dcache, addr);
+
+  //Check for a hit, the line must be present and hold the sector
+  uint32_t wayIndex;
+  struct way *line = lookupLine('D', address, &dcacheIndex, &wayIndex);
+  if(line && (line->valid & sector)) {
+    touchLine('D', dcacheIndex, wayIndex);
+    if(classify) { classifyAccess('D', addr >> dcache.fillBits, FALSE); }
+    if(l1mshrs) {
+      //A hit on a line still being filled waits for the fill
+      timingReady = timingNow + dcacheHitTime;
+      struct mshr *m = findMSHR(&dcache, address, timingNow);
+      if(m) {
+        dcacheMerges++;
+        if(m->ready > timingReady) { timingReady = m->ready; }
+      }
     }
+    return dcacheHitTime;
   }
 
   //Miss, so handle it appropriately
   dcacheMisses++;
-  uint32_t dcacheMissPenalty = l2cache_access(addr);
+  if(classify) { classifyAccess('D', addr >> dcache.fillBits, TRUE); }
+  if(profileTopK) { profile_miss(&dcache.profile, address, addr >> profileRegionBits); }
+  struct mshr *dcacheMshr = NULL;
+  if(l1mshrs) {
+    //The miss is known after the tag check and needs an MSHR to go out
+    timingNow += dcacheHitTime;
+    dcacheMshr = allocMSHR(&dcache, &timingNow, &dcacheMshrStalls);
+  }
+  uint32_t dcacheMissPenalty = l2cacheFill(addr, 1u << dcache.fillBits);
+  if(dcacheMshr) {
+    dcacheMshr->block = address;
+    dcacheMshr->ready = timingReady;
+  }
   dcachePenalties += dcacheMissPenalty;
   dcacheAccessTime = dcacheHitTime + dcacheMissPenalty;
 
-  //Add hit time to access time
-  int wayIndex = getWayIndex('D', dcacheIndex);
-  dcache.sets[dcacheIndex].ways[wayIndex].valid = 1;
-  dcache.sets[dcacheIndex].ways[wayIndex].tag = dcacheTag;
-  accessAndUpdateLRU('D', dcacheIndex, wayIndex);
+  //A line that is present only lacks the sector, otherwise fill the line
+  //chosen for replacement
+  if(line && line->valid) {
+    line->valid |= sector;
+  } else {
+    line = victimLine('D', address, &dcacheIndex, &wayIndex);
+    if(profileTopK) { profileEviction('D', dcacheIndex, line); }
+    line->valid = sector;
+    line->tag = dcacheTag;
+  }
+  touchLine('D', dcacheIndex, wayIndex);
   //TODO: Update icacheStatistics before returning
   //remove
   //print_dcache();
@@ -521,7 +1023,10 @@ uint32_t l2cache_access(uint32_t addr)
   // printf("Address: 0x%x\n", addr);
 
   //Base cases when l2cacheSets=0, l2cacheAssoc=0
-  if(l2cacheSets == 0 || l2cacheAssoc == 0) { return memspeed; }
+  if(l2cacheSets == 0 || l2cacheAssoc == 0) {
+    timingReady = timingNow;
+    return memoryAccess(addr, l1mshrs ? &timingReady : NULL);
+  }
 
   l2cacheRefs++;
 
@@ -531,86 +1036,72 @@ uint32_t l2cache_access(uint32_t addr)
   //Calculate index, tag
   uint32_t address = addr;
 
-  //remove the block offset bits
-  address = address >> blockOffsetBits;
-  l2cacheIndex = (l2cacheIndexBits == 0)? 0 : address % power(2,l2cacheIndexBits);
-  l2cacheTag = address / power(2,l2cacheIndexBits);
-
-  // printf("Index: %d, Tag: %d\n", l2cacheIndex, l2cacheTag);
-
-  //Check for a hit
-  struct set set_curr = l2cache.sets[l2cacheIndex];
-  for(j=0; j<l2cacheAssoc; j++) {
-    struct way way_curr = set_curr.ways[j];
-    if(way_curr.valid && way_curr.tag == l2cacheTag) {
-      accessAndUpdateLRU('L', l2cacheIndex, j);
-      return l2cacheHitTime;
+  //remove the block offset bits, the rest is the tag
+  address = address >> l2cache.lineBits;
+  l2cacheTag = address;
+  uint32_t sector = getSectorBit(&l2cache, addr);
+
+  //Check for a hit, the line must be present and hold the sector
+  uint32_t wayIndex;
+  struct way *line = lookupLine('L', address, &l2cacheIndex, &wayIndex);
+  if(line && (line->valid & sector)) {
+    touchLine('L', l2cacheIndex, wayIndex);
+    if(classify) { classifyAccess('L', addr >> l2cache.fillBits, FALSE); }
+    if(l1mshrs) {
+      //A hit on a line still being filled waits for the fill
+      timingReady = timingNow + l2cacheHitTime;
+      struct mshr *m = findMSHR(&l2cache, address, timingNow);
+      if(m) {
+        l2cacheMerges++;
+        if(m->ready > timingReady) { timingReady = m->ready; }
+      }
     }
+    return l2cacheHitTime;
   }
 
   //Miss, so handle it appropriately
   l2cacheMisses++;
-
-  if(inclusive == 0) {
-    //Non inclusive case
-    int wayIndex = getWayIndex('L', l2cacheIndex);
-    l2cache.sets[l2cacheIndex].ways[wayIndex].valid = 1;
-    l2cache.sets[l2cacheIndex].ways[wayIndex].tag = l2cacheTag;
-    accessAndUpdateLRU('L', l2cacheIndex, wayIndex);
+  if(classify) { classifyAccess('L', addr >> l2cache.fillBits, TRUE); }
+  if(profileTopK) { profile_miss(&l2cache.profile, address, addr >> profileRegionBits); }
+  uint32_t memTime;
+  if(l1mshrs) {
+    //Only the MSHRs and, with the DRAM model, the banks bound the misses
+    uint64_t issue = timingNow + l2cacheHitTime;
+    struct mshr *m = allocMSHR(&l2cache, &issue, &l2cacheMshrStalls);
+    memTime = memoryAccess(addr, &issue);
+    m->block = address;
+    m->ready = issue;
+    timingReady = m->ready;
+  } else {
+    memTime = memoryAccess(addr, NULL);
   }
-  else {
-    //Inclusive case
-    //Kick out the current block while checking for their presence in I/D caches
-
-    //Get the address of the current block waiting to be kicked out
-    uint32_t wayIndex = getWayIndex('L', l2cacheIndex);
-    uint32_t oldTag = l2cache.sets[l2cacheIndex].ways[wayIndex].tag;
-
-    uint32_t oldAddress = oldTag << l2cacheIndexBits;
-    oldAddress = oldAddress | l2cacheIndex;
-    // oldAddress = oldAddress << blockOffsetBits;
-
-    //I-cache entry eviction
-    //Calculate the index and tag of icache
-    uint32_t icacheIndex2 = (icacheIndexBits == 0)? 0 : oldAddress % power(2,icacheIndexBits);
-    uint32_t icacheTag2 = oldAddress / power(2,icacheIndexBits);
-
-    //Check whether the same entry exists in I cache
-    struct set set_curr = icache.sets[icacheIndex2];
-    for(j=0; j<icacheAssoc; j++) {
-      struct way way_curr = set_curr.ways[j];
-      if(way_curr.valid && way_curr.tag == icacheTag2) {
-        //If found, invalidate the entry
-        icache.sets[icacheIndex2].ways[j].valid = 0;
-      }
-    }
 
-    //D-cache entry eviction
-    //Calculate the index and tag of icache
-    uint32_t dcacheIndex2 = (dcacheIndexBits == 0)? 0 : oldAddress % power(2,dcacheIndexBits);
-    uint32_t dcacheTag2 = oldAddress / power(2,dcacheIndexBits);
-
-    //Check whether the same entry exists in D cache
-    set_curr = dcache.sets[dcacheIndex2];
-    for(j=0; j<dcacheAssoc; j++) {
-      struct way way_curr = set_curr.ways[j];
-      if(way_curr.valid && way_curr.tag == dcacheTag2) {
-        //If found, invalidate the entry
-        dcache.sets[dcacheIndex2].ways[j].valid = 0;
-      }
+  if(line) {
+    //The line is present and only lacks the sector
+    line->valid |= sector;
+  } else {
+    //Get the line waiting to be kicked out
+    line = victimLine('L', address, &l2cacheIndex, &wayIndex);
+
+    if(inclusive && line->valid) {
+      //Inclusive case
+      //Every L1 line or sector overlapping the line kicked out must
+      //leave the I and D caches as well
+      uint32_t base = line->tag << l2cache.lineBits;
+      if(iValid) { invalidateRange('I', base, 1u << l2cache.lineBits); }
+      if(dValid) { invalidateRange('D', base, 1u << l2cache.lineBits); }
     }
 
     //Now, replace the current entry with a new one
-    wayIndex = getWayIndex('L', l2cacheIndex);
-    l2cache.sets[l2cacheIndex].ways[wayIndex].valid = 1;
-    l2cache.sets[l2cacheIndex].ways[wayIndex].tag = l2cacheTag;
-    accessAndUpdateLRU('L', l2cacheIndex, wayIndex);
-
+    if(profileTopK) { profileEviction('L', l2cacheIndex, line); }
+    line->valid = sector;
+    line->tag = l2cacheTag;
   }
+  touchLine('L', l2cacheIndex, wayIndex);
 
-  l2cachePenalties += memspeed;
+  l2cachePenalties += memTime;
   //Add hit time to access time
-  l2cacheAccessTime = l2cacheHitTime + memspeed;
+  l2cacheAccessTime = l2cacheHitTime + memTime;
 
   //TODO: Update l2cacheStatistics before returning
   //remove
@@ -622,3 +1113,92 @@ uint32_t l2cache_access(uint32_t addr)
 
 
 
+
+//------------------------------------//
+//          Batch Functions           //
+//------------------------------------//
+
+// Accesses are handled in chunks whose set indices are computed up front,
+// and the sets PREFETCH_AHEAD accesses ahead are prefetched into the host's
+// caches while the current access is simulated. For a skewed cache only the
+// row of way 0 is prefetched
+#define BATCH_CHUNK    256
+#define PREFETCH_AHEAD 8
+
+//Function to prefetch the tags of set 'setIndex' of a cache
+void prefetchSet (struct cache *c, uint32_t setIndex) {
+  char *first = (char *)getSet(c, setIndex);
+  char *last = (char *)(getSet(c, setIndex) + c->assoc) - 1;
+  __builtin_prefetch(first, 1);
+  if((size_t)(last - first) >= 64) { __builtin_prefetch(last, 1); }
+}
+
+// Perform the accesses addrs[0..n-1] in order, directing access k to the
+// I$ if types[k] is 'I' and to the D$ otherwise, and store the access time
+// of each in times[k]. A NULL 'types' directs every access to 'i_or_d'
+//
+void batchAccess(const uint32_t *addrs, const char *types, char i_or_d,
+                 uint32_t *times, uint32_t n)
+{
+  uint32_t l1Set[BATCH_CHUNK];
+  uint32_t l2Set[BATCH_CHUNK];
+  uint32_t base, k;
+
+  for(base=0; base<n; base+=BATCH_CHUNK) {
+    uint32_t count = (n - base < BATCH_CHUNK) ? n - base : BATCH_CHUNK;
+
+    //Compute the sets of the whole chunk before touching any of them
+    for(k=0; k<count; k++) {
+      uint32_t addr = addrs[base + k];
+      char type = types ? types[base + k] : i_or_d;
+      struct cache *l1 = (type == 'I') ? &icache : &dcache;
+      l1Set[k] = l1->ways ? getSetIndex(l1, addr >> l1->lineBits) : 0;
+      l2Set[k] = l2cache.ways ? getSetIndex(&l2cache, addr >> l2cache.lineBits) : 0;
+    }
+
+    for(k=0; k<count; k++) {
+      if(k + PREFETCH_AHEAD < count) {
+        uint32_t ahead = k + PREFETCH_AHEAD;
+        char type = types ? types[base + ahead] : i_or_d;
+        struct cache *l1 = (type == 'I') ? &icache : &dcache;
+        if(l1->ways) { prefetchSet(l1, l1Set[ahead]); }
+        if(l2cache.ways) { prefetchSet(&l2cache, l2Set[ahead]); }
+      }
+
+      uint32_t addr = addrs[base + k];
+      char type = types ? types[base + k] : i_or_d;
+      if(l1mshrs) {
+        times[base + k] = timing_access(addr, type);
+        continue;
+      }
+      uint32_t translateTime = tlbEnabled ? tlb_translate(addr, type) : 0;
+      if(type == 'I') {
+        times[base + k] = translateTime + icache_access(addr);
+      } else {
+        times[base + k] = translateTime + dcache_access(addr);
+      }
+    }
+  }
+}
+
+// Perform a batch of accesses through the icache interface
+//
+void icache_access_batch(const uint32_t *addrs, uint32_t *times, uint32_t n)
+{
+  batchAccess(addrs, NULL, 'I', times, n);
+}
+
+// Perform a batch of accesses through the dcache interface
+//
+void dcache_access_batch(const uint32_t *addrs, uint32_t *times, uint32_t n)
+{
+  batchAccess(addrs, NULL, 'D', times, n);
+}
+
+// Perform a batch of accesses, each through the interface given by types[k]
+//
+void cache_access_batch(const uint32_t *addrs, const char *types,
+                        uint32_t *times, uint32_t n)
+{
+  batchAccess(addrs, types, 'D', times, n);
+}
@@ -26,6 +26,12 @@ extern const char *email;
 #define TRUE 1
 #define FALSE 0
 
+// Set index functions
+#define INDEX_MODULO 0   // Low bits of the block address
+#define INDEX_XOR    1   // Block address XOR-folded down to the index width
+#define INDEX_PRIME  2   // Block address modulo the largest prime <= sets
+#define INDEX_SKEW   3   // Skewed-associative, a different hash for each way
+
 //------------------------------------//
 //        Cache Configuration         //
 //------------------------------------//
@@ -33,19 +39,37 @@ extern const char *email;
 extern uint32_t icacheSets;     // Number of sets in the I$
 extern uint32_t icacheAssoc;    // Associativity of the I$
 extern uint32_t icacheHitTime;  // Hit Time of the I$
+extern uint32_t icacheIndexFn;  // Set index function of the I$
 
 extern uint32_t dcacheSets;     // Number of sets in the D$
 extern uint32_t dcacheAssoc;    // Associativity of the D$
 extern uint32_t dcacheHitTime;  // Hit Time of the D$
+extern uint32_t dcacheIndexFn;  // Set index function of the D$
 
 extern uint32_t l2cacheSets;    // Number of sets in the L2$
 extern uint32_t l2cacheAssoc;   // Associativity of the L2$
 extern uint32_t l2cacheHitTime; // Hit Time of the L2$
+extern uint32_t l2cacheIndexFn; // Set index function of the L2$
 extern uint32_t inclusive;      // Indicates if the L2 is inclusive
+extern uint32_t l2cacheWayMask; // L2$ ways new lines may be placed in (0 for any)
 
 extern uint32_t blocksize;      // Block/Line size
+extern uint32_t icacheBlocksize;  // Line size of the I$ (0 to use blocksize)
+extern uint32_t dcacheBlocksize;  // Line size of the D$ (0 to use blocksize)
+extern uint32_t l2cacheBlocksize; // Line size of the L2$ (0 to use blocksize)
+extern uint32_t icacheSectorsize; // Sector size of the I$ (0 for unsectored lines)
+extern uint32_t dcacheSectorsize; // Sector size of the D$ (0 for unsectored lines)
+extern uint32_t l2cacheSectorsize;// Sector size of the L2$ (0 for unsectored lines)
 extern uint32_t memspeed;       // Latency of Main Memory
 
+extern uint32_t l1mshrs;        // MSHRs in each L1 (0 disables the timing model)
+extern uint32_t l2mshrs;        // MSHRs in the L2$
+extern uint32_t missWindow;     // Misses the core can have outstanding
+extern uint32_t hugepages;      // Back the cache arena with transparent huge pages
+extern uint32_t classify;       // Split misses into compulsory, capacity and conflict
+extern uint32_t profileTopK;    // Lines, regions and sets reported by the miss profiler
+extern uint32_t profileRegion;  // Size of an address region of the miss profiler
+
 //------------------------------------//
 //          Cache Statistics          //
 //------------------------------------//
@@ -61,6 +85,24 @@ extern uint64_t dcachePenalties;  // D$ penalties
 extern uint64_t l2cacheRefs;      // L2$ references
 extern uint64_t l2cacheMisses;    // L2$ misses
 extern uint64_t l2cachePenalties; // L2$ penalties
+extern uint64_t l2cacheOverlapped;// L2$ accesses sent alongside another of one L1 fill
+
+extern uint64_t icacheMerges;     // I$ misses merged into an in-flight MSHR
+extern uint64_t icacheMshrStalls; // I$ misses that waited for a free MSHR
+extern uint64_t dcacheMerges;     // D$ misses merged into an in-flight MSHR
+extern uint64_t dcacheMshrStalls; // D$ misses that waited for a free MSHR
+extern uint64_t l2cacheMerges;    // L2$ misses merged into an in-flight MSHR
+extern uint64_t l2cacheMshrStalls;// L2$ misses that waited for a free MSHR
+
+extern uint64_t icacheCompulsory; // I$ misses to blocks never referenced before
+extern uint64_t icacheCapacity;   // I$ misses a fully-associative cache also takes
+extern uint64_t icacheConflict;   // I$ misses a fully-associative cache would hit
+extern uint64_t dcacheCompulsory; // D$ misses to blocks never referenced before
+extern uint64_t dcacheCapacity;   // D$ misses a fully-associative cache also takes
+extern uint64_t dcacheConflict;   // D$ misses a fully-associative cache would hit
+extern uint64_t l2cacheCompulsory;// L2$ misses to blocks never referenced before
+extern uint64_t l2cacheCapacity;  // L2$ misses a fully-associative cache also takes
+extern uint64_t l2cacheConflict;  // L2$ misses a fully-associative cache would hit
 
 //------------------------------------//
 //      Cache Function Prototypes     //
@@ -70,6 +112,25 @@ extern uint64_t l2cachePenalties; // L2$ penalties
 //
 void init_cache();
 
+// Check that a level of 'sets' sets can use the set index function 'indexFn'.
+// Only INDEX_PRIME reaches every set of a count that is not a power of two
+// Return TRUE if it can
+//
+int index_supports_sets(uint32_t indexFn, uint32_t sets);
+
+// Release the memory held by the cache hierarchy so that init_cache can be
+// called again, possibly with a different configuration
+//
+void free_cache();
+
+// Invalidate every line of the I$ and D$, as a flush on a context switch
+//
+void flush_l1();
+
+// Print the misses and evictions attributed by the miss profiler
+//
+void print_profile();
+
 // Perform a memory access through the icache interface for the address 'addr'
 // Return the access time for the memory operation
 //
@@ -85,4 +146,26 @@ uint32_t dcache_access(uint32_t addr);
 //
 uint32_t l2cache_access(uint32_t addr);
 
+// The batch interfaces also translate each access when a TLB is configured
+// and add the translation time, which icache_access and dcache_access do
+// not: the page walks themselves go through dcache_access
+//
+
+// Perform the accesses addrs[0..n-1] through the icache interface in order
+// Store the access time of addrs[k] in times[k]
+//
+void icache_access_batch(const uint32_t *addrs, uint32_t *times, uint32_t n);
+
+// Perform the accesses addrs[0..n-1] through the dcache interface in order
+// Store the access time of addrs[k] in times[k]
+//
+void dcache_access_batch(const uint32_t *addrs, uint32_t *times, uint32_t n);
+
+// Perform the accesses addrs[0..n-1] in order, through the icache interface
+// when types[k] is 'I' and through the dcache interface when it is 'D'
+// Store the access time of addrs[k] in times[k]
+//
+void cache_access_batch(const uint32_t *addrs, const char *types,
+                        uint32_t *times, uint32_t n);
+
 #endif
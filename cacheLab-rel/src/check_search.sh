@@ -0,0 +1,60 @@
+#!/bin/sh
+#========================================================#
+#  check_search.sh                                       #
+#  Checks the design-space search against direct runs    #
+#                                                        #
+#  Every configuration on the frontier the search        #
+#  reports is simulated on its own, and its AMAT must    #
+#  match the one the search worked out                   #
+#========================================================#
+
+CACHE=${CACHE:-./cache}
+TRACE=$(mktemp)
+trap 'rm -f "$TRACE"' EXIT
+status=0
+
+# A trace with a loop of fetches, random data and page-strided data
+awk 'BEGIN {
+  srand(1)
+  for (i = 0; i < 60000; i++) {
+    printf "0x%x I\n", 4096 + (i % 700) * 4
+    if (i % 3 == 0) { printf "0x%x D\n", int(rand() * 262144) * 8 }
+    if (i % 5 == 0) { printf "0x%x D\n", (i * 4096) % 1048576 }
+  }
+}' > "$TRACE"
+
+# check <level> <search options> <options>
+check() {
+  level=$1
+  search=$2
+  options=$3
+  rows=$($CACHE $options --search=$level --searchamat=100000 $search "$TRACE" |
+         awk '/^Pareto Frontier:/ { on = 1; next } on && $1 ~ /^[0-9]+$/ { print $2, $3, $4, $5 }')
+  if [ -z "$rows" ]; then
+    echo "FAIL: no frontier for $level with $options $search"
+    status=1
+    return
+  fi
+  echo "$rows" | while read sets assoc lat amat; do
+    direct=$($CACHE $options --$level=$sets:$assoc:$lat "$TRACE" |
+             awk '/^avg Memory access time:/ { print $5 }')
+    if [ "$direct" != "$amat" ]; then
+      echo "FAIL: $level $sets:$assoc:$lat with $options: search $amat, direct $direct"
+      exit 1
+    fi
+    echo "ok:   $level $sets:$assoc:$lat with $options: $amat"
+  done || status=1
+}
+
+# L1 fills that take several L2 accesses at once
+check l2cache "--searchlat=10,30" \
+  "--icache=64:2:2 --dcache=64:4:2 --l2cache=1024:8:10 --blocksize=128:128:64"
+check l2cache "--searchsets=128,256 --searchassoc=4,8 --searchlat=8,12" \
+  "--icache=64:2:2 --dcache=64:4:2 --l2cache=256:8:10 --blocksize=32:32:64 --inclusive"
+# Sectored lines and page walks through the D$
+check dcache "--searchlat=1,3" \
+  "--icache=64:2:2 --dcache=64:4:2 --l2cache=256:8:10 --blocksize=64 --sectorsize=64:32:16 --dtlb=64:4:1"
+check icache "--searchsets=32,64 --searchlat=1,2" \
+  "--icache=64:2:2 --dcache=64:4:2 --l2cache=256:8:10 --blocksize=64"
+
+exit $status
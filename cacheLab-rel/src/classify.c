@@ -0,0 +1,168 @@
+//========================================================//
+//  classify.c                                            //
+//  Source file for the three-C miss classifier           //
+//                                                        //
+//  Every operation is a hash lookup plus a constant      //
+//  number of list updates, independent of the size of   //
+//  the cache being classified                            //
+//========================================================//
+
+#include "classify.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SHADOW_NIL 0xffffffffu
+
+//------------------------------------//
+//          Helper Functions          //
+//------------------------------------//
+
+//Function to hash a block address into 'bits' bits
+uint32_t hashBlock (uint32_t block, uint32_t bits) {
+  return bits ? (block * 0x9e3779b1u) >> (32 - bits) : 0;
+}
+
+//Function to allocate zeroed memory or bail out
+void *shadowAlloc (size_t count, size_t size) {
+  void *ptr = calloc(count, size);
+  if(ptr == NULL) {
+    fprintf(stderr, "Unable to allocate the miss classifier\n");
+    exit(1);
+  }
+  return ptr;
+}
+
+//Function to get the home slot of 'key' in the seen set. The top bits of the
+//product are taken, the low ones only depend on the low bits of the key and
+//strided blocks would crowd into a few slots
+uint32_t seenHome (struct shadow *s, uint32_t key) {
+  return hashBlock(key, __builtin_popcount(s->seenMask));
+}
+
+//Function to add 'key' (a block address plus one) to the seen set
+//Returns TRUE if it was already there
+int seenInsert (struct shadow *s, uint32_t key) {
+  uint32_t slot = seenHome(s, key);
+  while(s->seen[slot]) {
+    if(s->seen[slot] == key) { return 1; }
+    slot = (slot + 1) & s->seenMask;
+  }
+  s->seen[slot] = key;
+
+  //Keep the load factor at or below one half
+  if(++s->seenCount > s->seenMask / 2) {
+    uint32_t *old = s->seen;
+    uint32_t oldMask = s->seenMask;
+    uint32_t k;
+    s->seenMask = oldMask * 2 + 1;
+    s->seen = shadowAlloc((size_t)s->seenMask + 1, sizeof(uint32_t));
+    for(k=0; k<=oldMask; k++) {
+      if(old[k] == 0) { continue; }
+      slot = seenHome(s, old[k]);
+      while(s->seen[slot]) { slot = (slot + 1) & s->seenMask; }
+      s->seen[slot] = old[k];
+    }
+    free(old);
+  }
+  return 0;
+}
+
+//Function to unlink node 'n' from the LRU list
+void listRemove (struct shadow *s, uint32_t n) {
+  struct shadow_node *node = &s->nodes[n];
+  if(node->prev != SHADOW_NIL) { s->nodes[node->prev].next = node->next; } else { s->mru = node->next; }
+  if(node->next != SHADOW_NIL) { s->nodes[node->next].prev = node->prev; } else { s->lru = node->prev; }
+}
+
+//Function to link node 'n' in at the MRU end of the LRU list
+void listPushMRU (struct shadow *s, uint32_t n) {
+  struct shadow_node *node = &s->nodes[n];
+  node->prev = SHADOW_NIL;
+  node->next = s->mru;
+  if(s->mru != SHADOW_NIL) { s->nodes[s->mru].prev = n; } else { s->lru = n; }
+  s->mru = n;
+}
+
+//Function to unlink node 'n' from its hash bucket
+void bucketRemove (struct shadow *s, uint32_t n) {
+  uint32_t *link = &s->buckets[hashBlock(s->nodes[n].block, s->bucketBits)];
+  while(*link != n) { link = &s->nodes[*link].chain; }
+  *link = s->nodes[n].chain;
+}
+
+//------------------------------------//
+//        Classifier Functions        //
+//------------------------------------//
+
+void shadow_init(struct shadow *s, uint32_t capacity)
+{
+  uint32_t k;
+
+  s->seenMask = 1023;
+  s->seenCount = 0;
+  s->seenMax = 0;
+  s->seen = shadowAlloc((size_t)s->seenMask + 1, sizeof(uint32_t));
+
+  //One bucket per block keeps the chains short
+  s->bucketBits = 0;
+  while((1u << s->bucketBits) < capacity && s->bucketBits < 31) { s->bucketBits++; }
+  s->buckets = shadowAlloc((size_t)1 << s->bucketBits, sizeof(uint32_t));
+  for(k=0; k<(1u << s->bucketBits); k++) { s->buckets[k] = SHADOW_NIL; }
+
+  s->nodes = shadowAlloc(capacity, sizeof(struct shadow_node));
+  s->capacity = capacity;
+  s->count = 0;
+  s->mru = SHADOW_NIL;
+  s->lru = SHADOW_NIL;
+}
+
+void shadow_free(struct shadow *s)
+{
+  free(s->seen);
+  free(s->buckets);
+  free(s->nodes);
+  s->seen = NULL;
+  s->buckets = NULL;
+  s->nodes = NULL;
+  s->capacity = 0;
+}
+
+int shadow_access(struct shadow *s, uint32_t block, int miss)
+{
+  //Has the block ever been referenced before?
+  int seen;
+  if(block == 0xffffffffu) {
+    seen = s->seenMax;
+    s->seenMax = 1;
+  } else {
+    seen = seenInsert(s, block + 1);
+  }
+
+  //Look the block up in the fully associative shadow
+  uint32_t *bucket = &s->buckets[hashBlock(block, s->bucketBits)];
+  uint32_t n = *bucket;
+  while(n != SHADOW_NIL && s->nodes[n].block != block) { n = s->nodes[n].chain; }
+
+  int shadowHit = (n != SHADOW_NIL);
+  if(shadowHit) {
+    listRemove(s, n);
+  } else {
+    //Take a free node, or recycle the LRU one
+    if(s->count < s->capacity) {
+      n = s->count++;
+    } else {
+      n = s->lru;
+      listRemove(s, n);
+      bucketRemove(s, n);
+    }
+    s->nodes[n].block = block;
+    s->nodes[n].chain = *bucket;
+    *bucket = n;
+  }
+  listPushMRU(s, n);
+
+  if(!miss) { return MISS_NONE; }
+  if(!seen) { return MISS_COMPULSORY; }
+  if(!shadowHit) { return MISS_CAPACITY; }
+  return MISS_CONFLICT;
+}
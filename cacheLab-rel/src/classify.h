@@ -0,0 +1,68 @@
+//========================================================//
+//  classify.h                                            //
+//  Header file for the three-C miss classifier           //
+//                                                        //
+//  Splits the misses of a cache into compulsory,         //
+//  capacity and conflict misses using the blocks seen    //
+//  so far and a fully-associative LRU shadow cache of    //
+//  the same capacity                                     //
+//========================================================//
+
+#ifndef CLASSIFY_H
+#define CLASSIFY_H
+
+#include <stdint.h>
+
+//------------------------------------//
+//         Classifier Defines         //
+//------------------------------------//
+
+#define MISS_NONE       0
+#define MISS_COMPULSORY 1
+#define MISS_CAPACITY   2
+#define MISS_CONFLICT   3
+
+// Entry of the shadow cache, linked both into its hash bucket and into the
+// LRU list. Links are node indices, SHADOW_NIL ends a list
+struct shadow_node {
+  uint32_t block;
+  uint32_t prev;    // Towards the MRU end
+  uint32_t next;    // Towards the LRU end
+  uint32_t chain;   // Next node in the same hash bucket
+};
+
+struct shadow {
+  // Every block referenced so far, an open addressed hash set of block+1
+  uint32_t *seen;
+  uint32_t seenMask;
+  uint32_t seenCount;
+  uint32_t seenMax;       // Block 0xffffffff, which has no +1 encoding
+
+  // Fully associative LRU cache of 'capacity' blocks
+  struct shadow_node *nodes;
+  uint32_t *buckets;
+  uint32_t bucketBits;
+  uint32_t capacity;
+  uint32_t count;
+  uint32_t mru;
+  uint32_t lru;
+};
+
+//------------------------------------//
+//    Classifier Function Prototypes  //
+//------------------------------------//
+
+// Set up a classifier for a cache holding 'capacity' blocks
+//
+void shadow_init(struct shadow *s, uint32_t capacity);
+
+// Release the memory of a classifier
+//
+void shadow_free(struct shadow *s);
+
+// Record an access to 'block', which hit or missed in the real cache
+// Return the class of the miss, MISS_NONE for a hit
+//
+int shadow_access(struct shadow *s, uint32_t block, int miss);
+
+#endif
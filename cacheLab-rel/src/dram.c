@@ -0,0 +1,193 @@
+//========================================================//
+//  dram.c                                                //
+//  Source file for the DRAM memory backend               //
+//                                                        //
+//  The address mapping is turned into a shift and mask   //
+//  per field at init_dram(), so an access is a handful   //
+//  of bit operations and one bank state update           //
+//========================================================//
+
+#define _GNU_SOURCE
+#include "dram.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//------------------------------------//
+//        DRAM Configuration          //
+//------------------------------------//
+
+uint32_t dramChannels;
+uint32_t dramRanks;
+uint32_t dramBanks;
+uint32_t dramRowSize;
+uint32_t dramCas;
+uint32_t dramRcd;
+uint32_t dramRp;
+uint32_t dramBus;
+uint32_t dramClosedRow;
+char dramMap[64];
+
+//------------------------------------//
+//          DRAM Statistics           //
+//------------------------------------//
+
+uint64_t dramRefs;
+uint64_t dramRowHits;
+uint64_t dramRowMisses;
+uint64_t dramRowConflicts;
+uint64_t dramCycles;
+
+//------------------------------------//
+//        DRAM Data Structures        //
+//------------------------------------//
+
+// Row buffer state of a bank
+struct bank {
+  uint32_t open;    // A row is open
+  uint32_t row;     // Row held in the row buffer
+  uint64_t ready;   // Cycle at which the bank finishes its last access
+};
+
+// Bank 'b' of rank 'r' of channel 'c' is banks[(c * ranks + r) * banks + b]
+struct bank *banks;
+
+//Position and width of each field of a DRAM address
+uint32_t fieldShift[DRAM_FIELDS];
+uint32_t fieldMask[DRAM_FIELDS];
+
+const char *fieldNames[DRAM_FIELDS] = { "row", "rank", "bank", "channel", "column" };
+
+//------------------------------------//
+//          Helper Functions          //
+//------------------------------------//
+
+//Function to get the bits needed to number 'count' things
+uint32_t dramBits (uint32_t count) {
+  uint32_t bits = 0;
+  while(bits < 32 && (1u << bits) < count) { bits++; }
+  return bits;
+}
+
+//Function to get a field of a DRAM address, kept below 'count'
+uint32_t dramField (uint32_t addr, int field, uint32_t count) {
+  uint32_t value = (addr >> fieldShift[field]) & fieldMask[field];
+  return (value < count) ? value : value % count;
+}
+
+//------------------------------------//
+//          DRAM Functions            //
+//------------------------------------//
+
+int dram_parse_map(const char *map, uint32_t order[DRAM_FIELDS])
+{
+  char copy[64];
+  uint32_t seen = 0, count = 0, f;
+  char *name, *save;
+
+  if(strlen(map) >= sizeof(copy)) { return -1; }
+  strcpy(copy, map);
+  for(name=strtok_r(copy, ":", &save); name; name=strtok_r(NULL, ":", &save)) {
+    for(f=0; f<DRAM_FIELDS && strcmp(name, fieldNames[f]); f++);
+    if(f == DRAM_FIELDS || (seen & (1u << f)) || count == DRAM_FIELDS) { return -1; }
+    seen |= 1u << f;
+    order[count++] = f;
+  }
+  return (count == DRAM_FIELDS) ? 0 : -1;
+}
+
+void init_dram()
+{
+  uint32_t width[DRAM_FIELDS];
+  uint32_t order[DRAM_FIELDS];
+  uint32_t shift, used, k;
+
+  dramRefs         = 0;
+  dramRowHits      = 0;
+  dramRowMisses    = 0;
+  dramRowConflicts = 0;
+  dramCycles       = 0;
+
+  if(dramChannels == 0) { return; }
+  if(dramRanks == 0) { dramRanks = 1; }
+  if(dramBanks == 0) { dramBanks = 1; }
+  if(dram_parse_map(dramMap, order) != 0) {
+    fprintf(stderr, "Invalid DRAM address mapping %s\n", dramMap);
+    exit(1);
+  }
+
+  //The row takes whatever address bits the other fields leave
+  width[DRAM_RANK]    = dramBits(dramRanks);
+  width[DRAM_BANK]    = dramBits(dramBanks);
+  width[DRAM_CHANNEL] = dramBits(dramChannels);
+  width[DRAM_COLUMN]  = dramBits(dramRowSize / DRAM_BURST);
+  used = dramBits(DRAM_BURST);
+  for(k=DRAM_RANK; k<DRAM_FIELDS; k++) { used += width[k]; }
+  width[DRAM_ROW] = (used < 32) ? 32 - used : 0;
+
+  //Fields are named most significant first, so lay them out from the end
+  shift = dramBits(DRAM_BURST);
+  for(k=DRAM_FIELDS; k-- > 0; ) {
+    uint32_t f = order[k];
+    if(shift < 32) {
+      fieldShift[f] = shift;
+      fieldMask[f] = (width[f] >= 32) ? 0xffffffffu : (1u << width[f]) - 1;
+    } else {
+      //Past the top of the address, the field is always 0
+      fieldShift[f] = 0;
+      fieldMask[f] = 0;
+    }
+    shift += width[f];
+  }
+
+  banks = calloc((size_t)dramChannels * dramRanks * dramBanks, sizeof(struct bank));
+  if(banks == NULL) {
+    fprintf(stderr, "Unable to allocate the DRAM banks\n");
+    exit(1);
+  }
+}
+
+void free_dram()
+{
+  free(banks);
+  banks = NULL;
+}
+
+uint32_t dram_access(uint32_t addr, uint64_t *ready)
+{
+  uint32_t channel = dramField(addr, DRAM_CHANNEL, dramChannels);
+  uint32_t rank = dramField(addr, DRAM_RANK, dramRanks);
+  uint32_t bank = dramField(addr, DRAM_BANK, dramBanks);
+  uint32_t row = (addr >> fieldShift[DRAM_ROW]) & fieldMask[DRAM_ROW];
+  struct bank *b = &banks[((size_t)channel * dramRanks + rank) * dramBanks + bank];
+  uint32_t latency;
+
+  if(b->open && b->row == row) {
+    //Row hit, the data is already in the row buffer
+    dramRowHits++;
+    latency = dramCas + dramBus;
+  } else if(b->open) {
+    //Row conflict, the open row is written back before the activation
+    dramRowConflicts++;
+    latency = dramRp + dramRcd + dramCas + dramBus;
+  } else {
+    //Row miss, the bank is precharged and only needs the activation
+    dramRowMisses++;
+    latency = dramRcd + dramCas + dramBus;
+  }
+
+  //A closed row policy precharges the bank right after the access
+  b->open = !dramClosedRow;
+  b->row = row;
+
+  dramRefs++;
+  dramCycles += latency;
+
+  //The bank serves one access at a time
+  if(ready) {
+    uint64_t start = (*ready > b->ready) ? *ready : b->ready;
+    *ready = start + latency;
+    b->ready = *ready;
+  }
+  return latency;
+}
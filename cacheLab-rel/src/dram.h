@@ -0,0 +1,80 @@
+//========================================================//
+//  dram.h                                                //
+//  Header file for the DRAM memory backend               //
+//                                                        //
+//  Replaces the flat 'memspeed' latency with channels,   //
+//  ranks and banks whose row buffers make the latency    //
+//  of a miss depend on the misses before it              //
+//========================================================//
+
+#ifndef DRAM_H
+#define DRAM_H
+
+#include <stdint.h>
+
+//------------------------------------//
+//          DRAM Defines              //
+//------------------------------------//
+
+// Bytes moved by one access, the low address bits below any mapped field
+#define DRAM_BURST 64
+
+// Fields of a DRAM address, in the order of the names in --drammap
+#define DRAM_ROW     0
+#define DRAM_RANK    1
+#define DRAM_BANK    2
+#define DRAM_CHANNEL 3
+#define DRAM_COLUMN  4
+#define DRAM_FIELDS  5
+
+//------------------------------------//
+//        DRAM Configuration          //
+//------------------------------------//
+
+extern uint32_t dramChannels;   // Channels, 0 keeps the flat memspeed model
+extern uint32_t dramRanks;      // Ranks per channel
+extern uint32_t dramBanks;      // Banks per rank
+extern uint32_t dramRowSize;    // Bytes in the row buffer of a bank
+extern uint32_t dramCas;        // Column access latency, tCAS
+extern uint32_t dramRcd;        // Row activation latency, tRCD
+extern uint32_t dramRp;         // Precharge latency, tRP
+extern uint32_t dramBus;        // Controller, bus and burst latency
+extern uint32_t dramClosedRow;  // Close the row after every access
+extern char dramMap[64];        // Address fields, most significant first
+
+//------------------------------------//
+//          DRAM Statistics           //
+//------------------------------------//
+
+extern uint64_t dramRefs;       // Accesses that reached the DRAM
+extern uint64_t dramRowHits;    // Accesses to the open row of their bank
+extern uint64_t dramRowMisses;  // Accesses to a bank with no open row
+extern uint64_t dramRowConflicts;// Accesses that closed another open row
+extern uint64_t dramCycles;     // Sum of the access latencies
+
+//------------------------------------//
+//     DRAM Function Prototypes       //
+//------------------------------------//
+
+// Parse 'map', the names of the address fields separated by ':' and most
+// significant first, e.g. row:rank:bank:channel:column
+// Return 0 if every field is named exactly once, -1 otherwise
+//
+int dram_parse_map(const char *map, uint32_t order[DRAM_FIELDS]);
+
+// Reset the DRAM statistics and allocate the banks
+//
+void init_dram();
+
+// Release the banks
+//
+void free_dram();
+
+// Access the DRAM at address 'addr'
+// Return the latency of the access. If 'ready' is not NULL it holds the
+// cycle the access is issued at and receives the cycle it completes at,
+// after waiting for its bank to finish earlier accesses
+//
+uint32_t dram_access(uint32_t addr, uint64_t *ready);
+
+#endif
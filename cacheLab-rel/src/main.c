@@ -9,10 +9,45 @@
 #include <stdlib.h>
 #include <string.h>
 #include "cache.h"
+#include "timing.h"
+#include "tlb.h"
+#include "dram.h"
+#include "ring.h"
+#include "runner.h"
+#include "search.h"
+#include "tenant.h"
+#include "main.h"
+
+// Number of trace records handed to the cache per batch
+#define BATCH_SIZE 4096
 
 FILE *stream;
 char *buf = NULL;
 size_t len = 0;
+uint32_t addr = 0;
+char i_or_d = '\0';
+
+uint32_t batchAddrs[BATCH_SIZE];
+char     batchTypes[BATCH_SIZE];
+uint32_t batchTimes[BATCH_SIZE];
+
+// Batch runner settings
+char *batchManifest = NULL;
+char *batchOutput = NULL;
+uint32_t batchJobs = 0;
+uint32_t batchMemLimit = 2048;
+
+// Design-space search settings, and the trace it loads
+struct search_space searchSpace;
+char *tracePath = NULL;
+
+// Traces interleaved on the hierarchy in a multi-tenant run, if any
+struct tenant_mix tenantMix;
+
+// Shared-memory ring the trace is streamed through, if any
+char *shmName = NULL;
+struct ring *ring = NULL;
+struct ring_record ringRecs[BATCH_SIZE];
 
 // Print out the Usage information to stderr
 //
@@ -21,14 +56,91 @@ usage()
 {
   fprintf(stderr,"Usage: cache <options> [<trace>]\n");
   fprintf(stderr,"       bunzip -kc trace.bz2 | cache <options>\n");
+  fprintf(stderr,"       cache <options> --shm=name\n");
+  fprintf(stderr,"       cache --batch=manifest [--jobs=n] [--memlimit=MiB] [--output=file]\n");
+  fprintf(stderr,"       cache <options> --search=level --searchamat=cycles [--searchbudget=bytes]\n");
+  fprintf(stderr,"             [--searchsets=list] [--searchassoc=list] [--searchlat=list] <trace>\n");
+  fprintf(stderr,"       cache <options> --tenant=trace[:waymask] --tenant=trace[:waymask] ...\n");
+  fprintf(stderr,"             [--schedule=rr|list] [--timeslice=n] [--flushl1]\n");
   fprintf(stderr," Options:\n");
   fprintf(stderr," --help                     Print this message\n");
   fprintf(stderr," --icache=sets:assoc:hit    I-cache Parameters\n");
   fprintf(stderr," --dcache=sets:assoc:hit    D-cache Parameters\n");
   fprintf(stderr," --l2cache=sets:assoc:hit   L2-cache Parameters\n");
+  fprintf(stderr,"   add :mod, :xor, :prime or :skew to pick the set index function\n");
   fprintf(stderr," --inclusive                Makes L2-cache be inclusive\n");
-  fprintf(stderr," --blocksize=size           Block/Line size\n");
+  fprintf(stderr," --itlb=entries:assoc:hit   I-TLB Parameters\n");
+  fprintf(stderr," --dtlb=entries:assoc:hit   D-TLB Parameters\n");
+  fprintf(stderr," --l2tlb=entries:assoc:hit  L2-TLB Parameters\n");
+  fprintf(stderr," --pagesize=size            Page size: 4K, 2M or 1G\n");
+  fprintf(stderr," --blocksize=size           Block/Line size, or i:d:l2 for each level\n");
+  fprintf(stderr," --sectorsize=size          Sector size of the lines, or i:d:l2\n");
   fprintf(stderr," --memspeed=latency         Latency to Main Memory\n");
+  fprintf(stderr," --dram=ch:ranks:banks:row  DRAM backend in place of memspeed\n");
+  fprintf(stderr," --dramtiming=cas:rcd:rp:bus  DRAM latencies in cycles\n");
+  fprintf(stderr," --rowpolicy=open|closed    DRAM row buffer policy\n");
+  fprintf(stderr," --drammap=fields           DRAM address mapping, e.g. row:rank:bank:channel:column\n");
+  fprintf(stderr," --mshr=l1:l2:window        Non-blocking timing model with MSHRs\n");
+  fprintf(stderr," --hugepages                Back the caches with huge pages\n");
+  fprintf(stderr," --shm=name                 Read the trace from a shared-memory ring\n");
+  fprintf(stderr," --classify                 Split misses into compulsory/capacity/conflict\n");
+  fprintf(stderr," --profile=topk:region      Report the lines, regions and sets that miss most\n");
+  fprintf(stderr," --tenant=trace[:waymask]   Interleave the trace of a tenant with the others\n");
+}
+
+// Names of the set index functions
+const char *indexNames[] = { "mod", "xor", "prime", "skew" };
+
+// Process the parameters of a cache level, sets:assoc:hit[:index]
+//
+// Returns True if Successful
+//
+int
+handle_cache(const char *arg, uint32_t *sets, uint32_t *assoc,
+             uint32_t *hitTime, uint32_t *indexFn)
+{
+  char name[8] = "";
+  sscanf(arg,"%u:%u:%u:%7s", sets, assoc, hitTime, name);
+  if (name[0] == '\0') {
+    *indexFn = INDEX_MODULO;
+  } else {
+    for (*indexFn = INDEX_MODULO; *indexFn <= INDEX_SKEW; (*indexFn)++) {
+      if (!strcmp(name, indexNames[*indexFn])) { break; }
+    }
+    if (*indexFn > INDEX_SKEW) { return 0; }
+  }
+  if (!index_supports_sets(*indexFn, *sets)) {
+    fprintf(stderr,"%u sets is not a power of two, use the :prime index\n", *sets);
+    return 0;
+  }
+  return 1;
+}
+
+// Process a size given for every level, size, or for each, i:d:l2
+//
+// Returns True if Successful
+//
+int
+handle_sizes(const char *arg, uint32_t *isize, uint32_t *dsize, uint32_t *l2size)
+{
+  int n = sscanf(arg,"%u:%u:%u", isize, dsize, l2size);
+  if (n == 1) { *dsize = *l2size = *isize; }
+  return n == 1 || n == 3;
+}
+
+// Process a page size, in bytes or with a K, M or G suffix
+//
+// Returns True if it is 4 KiB, 2 MiB or 1 GiB
+//
+int
+handle_pagesize(const char *arg)
+{
+  char unit = '\0';
+  if (sscanf(arg,"%u%c", &pagesize, &unit) < 1) { return 0; }
+  if (unit == 'K' || unit == 'k') { pagesize <<= 10; }
+  if (unit == 'M' || unit == 'm') { pagesize <<= 20; }
+  if (unit == 'G' || unit == 'g') { pagesize <<= 30; }
+  return pagesize == (4u << 10) || pagesize == (2u << 20) || pagesize == (1u << 30);
 }
 
 // Process an option and update the cache
@@ -40,17 +152,85 @@ int
 handle_option(char *arg)
 {
   if (!strncmp(arg,"--icache=",9)) {
-    sscanf(arg+9,"%u:%u:%u", &icacheSets, &icacheAssoc, &icacheHitTime);
+    return handle_cache(arg+9, &icacheSets, &icacheAssoc, &icacheHitTime, &icacheIndexFn);
   } else if (!strncmp(arg,"--dcache=",9)) {
-    sscanf(arg+9,"%u:%u:%u", &dcacheSets, &dcacheAssoc, &dcacheHitTime);
+    return handle_cache(arg+9, &dcacheSets, &dcacheAssoc, &dcacheHitTime, &dcacheIndexFn);
   } else if (!strncmp(arg,"--l2cache=",10)) {
-    sscanf(arg+10,"%u:%u:%u", &l2cacheSets, &l2cacheAssoc, &l2cacheHitTime);
+    return handle_cache(arg+10, &l2cacheSets, &l2cacheAssoc, &l2cacheHitTime, &l2cacheIndexFn);
+  } else if (!strncmp(arg,"--itlb=",7)) {
+    sscanf(arg+7,"%u:%u:%u", &itlbEntries, &itlbAssoc, &itlbHitTime);
+  } else if (!strncmp(arg,"--dtlb=",7)) {
+    sscanf(arg+7,"%u:%u:%u", &dtlbEntries, &dtlbAssoc, &dtlbHitTime);
+  } else if (!strncmp(arg,"--l2tlb=",8)) {
+    sscanf(arg+8,"%u:%u:%u", &l2tlbEntries, &l2tlbAssoc, &l2tlbHitTime);
+  } else if (!strncmp(arg,"--pagesize=",11)) {
+    return handle_pagesize(arg+11);
   } else if (!strcmp(arg,"--inclusive")) {
     inclusive = TRUE;
   } else if (!strncmp(arg,"--blocksize=",12)) {
+    if (strchr(arg+12,':')) {
+      return handle_sizes(arg+12, &icacheBlocksize, &dcacheBlocksize, &l2cacheBlocksize);
+    }
     sscanf(arg+12,"%u", &blocksize);
+    icacheBlocksize = dcacheBlocksize = l2cacheBlocksize = 0;
+  } else if (!strncmp(arg,"--sectorsize=",13)) {
+    return handle_sizes(arg+13, &icacheSectorsize, &dcacheSectorsize, &l2cacheSectorsize);
   } else if (!strncmp(arg,"--memspeed=",11)) {
     sscanf(arg+11,"%u", &memspeed);
+  } else if (!strncmp(arg,"--dram=",7)) {
+    sscanf(arg+7,"%u:%u:%u:%u", &dramChannels, &dramRanks, &dramBanks, &dramRowSize);
+  } else if (!strncmp(arg,"--dramtiming=",13)) {
+    sscanf(arg+13,"%u:%u:%u:%u", &dramCas, &dramRcd, &dramRp, &dramBus);
+  } else if (!strcmp(arg,"--rowpolicy=open")) {
+    dramClosedRow = FALSE;
+  } else if (!strcmp(arg,"--rowpolicy=closed")) {
+    dramClosedRow = TRUE;
+  } else if (!strncmp(arg,"--drammap=",10)) {
+    uint32_t order[DRAM_FIELDS];
+    if (dram_parse_map(arg+10, order) != 0) { return 0; }
+    strcpy(dramMap, arg+10);
+  } else if (!strncmp(arg,"--mshr=",7)) {
+    sscanf(arg+7,"%u:%u:%u", &l1mshrs, &l2mshrs, &missWindow);
+  } else if (!strcmp(arg,"--hugepages")) {
+    hugepages = TRUE;
+  } else if (!strncmp(arg,"--profile=",10)) {
+    sscanf(arg+10,"%u:%u", &profileTopK, &profileRegion);
+  } else if (!strcmp(arg,"--classify")) {
+    classify = TRUE;
+  } else if (!strncmp(arg,"--shm=",6)) {
+    shmName = arg+6;
+  } else if (!strncmp(arg,"--batch=",8)) {
+    batchManifest = arg+8;
+  } else if (!strncmp(arg,"--jobs=",7)) {
+    sscanf(arg+7,"%u", &batchJobs);
+  } else if (!strncmp(arg,"--memlimit=",11)) {
+    sscanf(arg+11,"%u", &batchMemLimit);
+  } else if (!strncmp(arg,"--output=",9)) {
+    batchOutput = arg+9;
+  } else if (!strcmp(arg,"--search=icache")) {
+    searchSpace.level = 'I';
+  } else if (!strcmp(arg,"--search=dcache")) {
+    searchSpace.level = 'D';
+  } else if (!strcmp(arg,"--search=l2cache")) {
+    searchSpace.level = 'L';
+  } else if (!strncmp(arg,"--searchamat=",13)) {
+    sscanf(arg+13,"%lf", &searchSpace.target);
+  } else if (!strncmp(arg,"--searchbudget=",15)) {
+    sscanf(arg+15,"%llu", (unsigned long long *)&searchSpace.budget);
+  } else if (!strncmp(arg,"--searchsets=",13)) {
+    return search_parse_list(arg+13, searchSpace.sets, &searchSpace.setCount) == 0;
+  } else if (!strncmp(arg,"--searchassoc=",14)) {
+    return search_parse_list(arg+14, searchSpace.assoc, &searchSpace.assocCount) == 0;
+  } else if (!strncmp(arg,"--searchlat=",12)) {
+    return search_parse_list(arg+12, searchSpace.lat, &searchSpace.latCount) == 0;
+  } else if (!strncmp(arg,"--tenant=",9)) {
+    return tenant_add(&tenantMix, arg+9) == 0;
+  } else if (!strncmp(arg,"--schedule=",11)) {
+    return tenant_parse_schedule(&tenantMix, arg+11) == 0;
+  } else if (!strncmp(arg,"--timeslice=",12)) {
+    sscanf(arg+12,"%u", &tenantMix.timeslice);
+  } else if (!strcmp(arg,"--flushl1")) {
+    tenantMix.flushL1 = TRUE;
   } else {
     return 0;
   }
@@ -66,6 +246,20 @@ printStudentInfo()
   printf("Student email: %s\n\n", email);
 }
 
+// Print out the line and sector size of a level, if they are its own
+//
+void
+printLines(uint32_t lineSize, uint32_t sectorSize)
+{
+  if (lineSize == 0) { lineSize = blocksize; }
+  if (lineSize != blocksize) {
+    printf("    Line:  %u Bytes\n", lineSize);
+  }
+  if (sectorSize && sectorSize < lineSize) {
+    printf("    Sector:%u Bytes\n", sectorSize);
+  }
+}
+
 // Print out the memory hierarchy
 //
 void
@@ -75,30 +269,82 @@ printCacheConfig()
   // Print I$ Configuration
   if (icacheSets) {
     printf("  I$ Configuration:\n");
-    printf("    Size:  %u Bytes\n", icacheSets * icacheAssoc * blocksize);
+    printf("    Size:  %u Bytes\n", icacheSets * icacheAssoc * (icacheBlocksize ? icacheBlocksize : blocksize));
     printf("    Sets:  %u\n", icacheSets);
     printf("    Assoc: %u\n", icacheAssoc);
     printf("    Lat:   %u Cycles\n", icacheHitTime);
+    printLines(icacheBlocksize, icacheSectorsize);
+    if (icacheIndexFn != INDEX_MODULO) {
+      printf("    Index: %s\n", indexNames[icacheIndexFn]);
+    }
   }
   // Print D$ Configuration
   if (dcacheSets) {
     printf("  D$ Configuration:\n");
-    printf("    Size:  %u Bytes\n", dcacheSets * dcacheAssoc * blocksize);
+    printf("    Size:  %u Bytes\n", dcacheSets * dcacheAssoc * (dcacheBlocksize ? dcacheBlocksize : blocksize));
     printf("    Sets:  %u\n", dcacheSets);
     printf("    Assoc: %u\n", dcacheAssoc);
     printf("    Lat:   %u Cycles\n", dcacheHitTime);
+    printLines(dcacheBlocksize, dcacheSectorsize);
+    if (dcacheIndexFn != INDEX_MODULO) {
+      printf("    Index: %s\n", indexNames[dcacheIndexFn]);
+    }
   }
   // Print L2$ Configuration
   if (l2cacheSets) {
     printf("  L2$ Configuration:\n");
-    printf("    Size:  %u Bytes\n", l2cacheSets * l2cacheAssoc * blocksize);
+    printf("    Size:  %u Bytes\n", l2cacheSets * l2cacheAssoc * (l2cacheBlocksize ? l2cacheBlocksize : blocksize));
     printf("    Sets:  %u\n", l2cacheSets);
     printf("    Assoc: %u\n", l2cacheAssoc);
     printf("    Lat:   %u Cycles\n", l2cacheHitTime);
+    printLines(l2cacheBlocksize, l2cacheSectorsize);
+    if (l2cacheIndexFn != INDEX_MODULO) {
+      printf("    Index: %s\n", indexNames[l2cacheIndexFn]);
+    }
     printf("    Inclusive: %s\n", inclusive ? "Yes" : "No");
   }
+  // Print I-TLB Configuration
+  if (itlbEntries) {
+    printf("  I-TLB Configuration:\n");
+    printf("    Entries: %u\n", itlbEntries);
+    printf("    Assoc: %u\n", itlbAssoc);
+    printf("    Lat:   %u Cycles\n", itlbHitTime);
+  }
+  // Print D-TLB Configuration
+  if (dtlbEntries) {
+    printf("  D-TLB Configuration:\n");
+    printf("    Entries: %u\n", dtlbEntries);
+    printf("    Assoc: %u\n", dtlbAssoc);
+    printf("    Lat:   %u Cycles\n", dtlbHitTime);
+  }
+  // Print L2-TLB Configuration
+  if (l2tlbEntries) {
+    printf("  L2-TLB Configuration:\n");
+    printf("    Entries: %u\n", l2tlbEntries);
+    printf("    Assoc: %u\n", l2tlbAssoc);
+    printf("    Lat:   %u Cycles\n", l2tlbHitTime);
+  }
+  if (itlbEntries || dtlbEntries || l2tlbEntries) {
+    printf("  Page Size:  %u Bytes\n", pagesize);
+  }
   printf("  Block Size: %u Bytes\n", blocksize);
-  printf("  Memspeed:   %u Cycles\n", memspeed);
+  if (dramChannels) {
+    printf("  DRAM Configuration:\n");
+    printf("    Channels: %u\n", dramChannels);
+    printf("    Ranks:    %u\n", dramRanks);
+    printf("    Banks:    %u\n", dramBanks);
+    printf("    Row Size: %u Bytes\n", dramRowSize);
+    printf("    Timing:   %u:%u:%u:%u Cycles\n", dramCas, dramRcd, dramRp, dramBus);
+    printf("    Policy:   %s\n", dramClosedRow ? "closed" : "open");
+    printf("    Mapping:  %s\n", dramMap);
+  } else {
+    printf("  Memspeed:   %u Cycles\n", memspeed);
+  }
+  if (l1mshrs) {
+    printf("  L1 MSHRs:   %u\n", l1mshrs);
+    printf("  L2 MSHRs:   %u\n", l2mshrs);
+    printf("  Miss Window:%u\n", missWindow);
+  }
 }
 
 // Print out the Cache Statistics
@@ -111,6 +357,11 @@ printCacheStats()
     printf("  total I-cache accesses:  %13llu\n", icacheRefs);
     printf("  total I-cache misses:    %13llu\n", icacheMisses);
     printf("  total I-cache penalties: %13llu\n", icachePenalties);
+    if (classify) {
+      printf("  I-cache compulsory:      %13llu\n", icacheCompulsory);
+      printf("  I-cache capacity:        %13llu\n", icacheCapacity);
+      printf("  I-cache conflict:        %13llu\n", icacheConflict);
+    }
     if (icacheRefs > 0) {
       printf("  I-cache miss rate:   %17.2f%%\n",
           100.0*(double)icacheMisses/(double)icacheRefs);
@@ -126,6 +377,11 @@ printCacheStats()
     printf("  total D-cache accesses:  %13llu\n", dcacheRefs);
     printf("  total D-cache misses:    %13llu\n", dcacheMisses);
     printf("  total D-cache penalties: %13llu\n", dcachePenalties);
+    if (classify) {
+      printf("  D-cache compulsory:      %13llu\n", dcacheCompulsory);
+      printf("  D-cache capacity:        %13llu\n", dcacheCapacity);
+      printf("  D-cache conflict:        %13llu\n", dcacheConflict);
+    }
     if (dcacheRefs > 0) {
       printf("  D-cache miss rate:   %17.2f%%\n",
           100.0*(double)dcacheMisses/(double)dcacheRefs);
@@ -141,6 +397,11 @@ printCacheStats()
     printf("  total L2-cache accesses: %13llu\n", l2cacheRefs);
     printf("  total L2-cache misses:   %13llu\n", l2cacheMisses);
     printf("  total L2-cache penalties:%13llu\n", l2cachePenalties);
+    if (classify) {
+      printf("  L2-cache compulsory:     %13llu\n", l2cacheCompulsory);
+      printf("  L2-cache capacity:       %13llu\n", l2cacheCapacity);
+      printf("  L2-cache conflict:       %13llu\n", l2cacheConflict);
+    }
     if (l2cacheRefs > 0) {
       printf("  L2-cache miss rate:  %17.2f%%\n",
           100.0*(double)l2cacheMisses/(double)l2cacheRefs);
@@ -152,6 +413,75 @@ printCacheStats()
       printf("  avg L2-cache access time:            -\n");
     }
   }
+  if (itlbEntries) {
+    printf("  total I-TLB accesses:    %13llu\n", itlbRefs);
+    printf("  total I-TLB misses:      %13llu\n", itlbMisses);
+    if (itlbRefs > 0) {
+      printf("  I-TLB miss rate:     %17.2f%%\n",
+          100.0*(double)itlbMisses/(double)itlbRefs);
+    }
+  }
+  if (dtlbEntries) {
+    printf("  total D-TLB accesses:    %13llu\n", dtlbRefs);
+    printf("  total D-TLB misses:      %13llu\n", dtlbMisses);
+    if (dtlbRefs > 0) {
+      printf("  D-TLB miss rate:     %17.2f%%\n",
+          100.0*(double)dtlbMisses/(double)dtlbRefs);
+    }
+  }
+  if (l2tlbEntries) {
+    printf("  total L2-TLB accesses:   %13llu\n", l2tlbRefs);
+    printf("  total L2-TLB misses:     %13llu\n", l2tlbMisses);
+    if (l2tlbRefs > 0) {
+      printf("  L2-TLB miss rate:    %17.2f%%\n",
+          100.0*(double)l2tlbMisses/(double)l2tlbRefs);
+    }
+  }
+  if (tlbEnabled) {
+    printf("  total page walks:        %13llu\n", pageWalks);
+    printf("  total walk accesses:     %13llu\n", walkRefs);
+    printf("  total walk penalties:    %13llu\n", walkPenalties);
+    printf("  total TLB penalties:     %13llu\n", tlbPenalties);
+  }
+  if (dramChannels) {
+    printf("  total DRAM accesses:     %13llu\n", dramRefs);
+    printf("  DRAM row hits:           %13llu\n", dramRowHits);
+    printf("  DRAM row misses:         %13llu\n", dramRowMisses);
+    printf("  DRAM row conflicts:      %13llu\n", dramRowConflicts);
+    if (dramRefs > 0) {
+      printf("  avg DRAM access time:    %13.2f cycles\n",
+          (double)dramCycles / dramRefs);
+    }
+  }
+}
+
+// Print out the statistics of the non-blocking timing model
+//
+void
+printTimingStats()
+{
+  printf("Timing Statistics:\n");
+  if (icacheSets) {
+    printf("  I-cache MSHR merges:     %13llu\n", icacheMerges);
+    printf("  I-cache MSHR stalls:     %13llu\n", icacheMshrStalls);
+  }
+  if (dcacheSets) {
+    printf("  D-cache MSHR merges:     %13llu\n", dcacheMerges);
+    printf("  D-cache MSHR stalls:     %13llu\n", dcacheMshrStalls);
+  }
+  if (l2cacheSets) {
+    printf("  L2-cache MSHR merges:    %13llu\n", l2cacheMerges);
+    printf("  L2-cache MSHR stalls:    %13llu\n", l2cacheMshrStalls);
+  }
+  printf("  miss window stalls:      %13llu\n", timingWindowStalls);
+  printf("  outstanding misses:      %13llu\n", timingMisses);
+  printf("  effective cycles:        %13llu\n", timingCycles);
+  if (timingBusyCycles > 0) {
+    printf("  memory-level parallelism:%13.2f\n",
+        (double)timingMissCycles / timingBusyCycles);
+  } else {
+    printf("  memory-level parallelism:            -\n");
+  }
 }
 
 // Set the defaults for the Cache Simulator
@@ -172,9 +502,46 @@ set_defaults()
   l2cacheSets     = 0;
   l2cacheAssoc    = 0;
   l2cacheHitTime  = 0;
+  icacheIndexFn   = INDEX_MODULO;
+  dcacheIndexFn   = INDEX_MODULO;
+  l2cacheIndexFn  = INDEX_MODULO;
   inclusive       = 0;
+  l2cacheWayMask  = 0;
   blocksize       = 16;
+  icacheBlocksize = 0;
+  dcacheBlocksize = 0;
+  l2cacheBlocksize = 0;
+  icacheSectorsize = 0;
+  dcacheSectorsize = 0;
+  l2cacheSectorsize = 0;
   memspeed        = 50;
+  dramChannels    = 0;
+  dramRanks       = 1;
+  dramBanks       = 8;
+  dramRowSize     = 8192;
+  dramCas         = 15;
+  dramRcd         = 15;
+  dramRp          = 15;
+  dramBus         = 10;
+  dramClosedRow   = 0;
+  strcpy(dramMap, "row:rank:bank:channel:column");
+  l1mshrs         = 0;
+  l2mshrs         = 0;
+  missWindow      = 0;
+  hugepages       = 0;
+  classify        = 0;
+  profileTopK     = 0;
+  profileRegion   = 4096;
+  itlbEntries     = 0;
+  itlbAssoc       = 0;
+  itlbHitTime     = 0;
+  dtlbEntries     = 0;
+  dtlbAssoc       = 0;
+  dtlbHitTime     = 0;
+  l2tlbEntries    = 0;
+  l2tlbAssoc      = 0;
+  l2tlbHitTime    = 0;
+  pagesize        = 4096;
 }
 
 // Reads a line from the input stream and extracts the
@@ -194,6 +561,52 @@ read_mem_access(uint32_t *addr, char *i_or_d)
   return 1;
 }
 
+// Check that an access is directed to either the I$ or the D$
+//
+void
+check_mem_access(char i_or_d)
+{
+  if (i_or_d != 'I' && i_or_d != 'D') {
+    fprintf(stderr,"Input Error '%c' must be either 'I' or 'D'\n", i_or_d);
+    exit(1);
+  }
+}
+
+// Fills the batch arrays with the next memory accesses of the trace, read
+// from the shared-memory ring if one is attached and the input stream
+// otherwise
+//
+// Returns the number of accesses read, 0 at the end of the trace
+//
+uint32_t
+read_batch()
+{
+  uint32_t count = 0;
+
+  if (ring) {
+    count = ring_pop(ring, ringRecs, BATCH_SIZE);
+    for (uint32_t k = 0; k < count; k++) {
+      // Check the whole field, narrowing it first could turn junk into 'I'
+      if (ringRecs[k].type != 'I' && ringRecs[k].type != 'D') {
+        fprintf(stderr,"Input Error 0x%x must be either 'I' or 'D'\n", ringRecs[k].type);
+        ring_detach(ring);
+        exit(1);
+      }
+      batchAddrs[k] = ringRecs[k].addr;
+      batchTypes[k] = ringRecs[k].type;
+    }
+    return count;
+  }
+
+  while (count < BATCH_SIZE && read_mem_access(&addr, &i_or_d)) {
+    check_mem_access(i_or_d);
+    batchAddrs[count] = addr;
+    batchTypes[count] = i_or_d;
+    count++;
+  }
+  return count;
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -214,6 +627,39 @@ main(int argc, char *argv[])
     } else {
       // Use as input file
       stream = fopen(argv[i], "r");
+      tracePath = argv[i];
+    }
+  }
+
+  // Each run reads its accesses from exactly one place
+  if (tenantMix.count && (tracePath || shmName || batchManifest || searchSpace.level)) {
+    fprintf(stderr,"--tenant cannot be combined with a trace, --shm, --batch or --search\n");
+    usage();
+    exit(1);
+  }
+  if (shmName && (tracePath || batchManifest || searchSpace.level)) {
+    fprintf(stderr,"--shm cannot be combined with a trace, --batch or --search\n");
+    usage();
+    exit(1);
+  }
+
+  // Run every job of a manifest instead of a single trace
+  if (batchManifest) {
+    return run_batch(batchManifest, batchOutput, batchJobs, batchMemLimit);
+  }
+
+  // Search the configurations of one level instead of simulating one
+  if (searchSpace.level) {
+    return run_search(tracePath ? tracePath : "/dev/stdin", &searchSpace);
+  }
+
+  // Attach to the trace ring before building the caches, the producer
+  // may not be running yet
+  if (shmName) {
+    ring = ring_attach(shmName);
+    if (ring == NULL) {
+      fprintf(stderr,"Unable to attach to trace ring %s\n", shmName);
+      exit(1);
     }
   }
 
@@ -222,21 +668,25 @@ main(int argc, char *argv[])
 
   uint64_t totalRefs = 0;
   uint64_t totalPenalties = 0;  //NOTE: Total Penalty = Total Access Time (Hit time + Miss Time)
-  uint32_t addr = 0;
-  char i_or_d = '\0';
-
-  // Read each memory access from the trace
-  while (read_mem_access(&addr, &i_or_d)) {
-    totalRefs++;
-    // Direct the memory access to the appropriate cache
-    if (i_or_d == 'I') {
-      totalPenalties += icache_access(addr);
-    } else if (i_or_d == 'D') {
-      totalPenalties += dcache_access(addr);
-    } else {
-      fprintf(stderr,"Input Error '%c' must be either 'I' or 'D'\n", i_or_d);
+  uint32_t count = 0;
+
+  // Interleave the traces of the tenants, or read the trace in batches and
+  // direct each batch of memory accesses to the appropriate caches
+  if (tenantMix.count) {
+    if (run_tenants(&tenantMix, &totalRefs, &totalPenalties) != 0) {
       exit(1);
     }
+  } else {
+    while ((count = read_batch())) {
+      cache_access_batch(batchAddrs, batchTypes, batchTimes, count);
+      for (uint32_t k = 0; k < count; k++) {
+        totalPenalties += batchTimes[k];
+      }
+      totalRefs += count;
+    }
+  }
+  if (l1mshrs) {
+    timing_finish();
   }
 
   // Print out the statistics
@@ -251,8 +701,22 @@ main(int argc, char *argv[])
   } else {
     printf("avg Memory access time:                -\n");
   }
+  if (l1mshrs) {
+    printTimingStats();
+  }
+  if (profileTopK) {
+    print_profile();
+  }
+  if (tenantMix.count) {
+    print_tenants(&tenantMix);
+  }
 
   // Cleanup
+  free_cache();
+  tenant_free(&tenantMix);
+  if (ring) {
+    ring_detach(ring);
+  }
   fclose(stream);
   free(buf);
 
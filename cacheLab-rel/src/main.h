@@ -0,0 +1,23 @@
+//========================================================//
+//  main.h                                                //
+//  Header file for the command line handling in main.c   //
+//                                                        //
+//  Shared with the modes that build many cache           //
+//  configurations in one run                             //
+//========================================================//
+
+#ifndef MAIN_H
+#define MAIN_H
+
+// Set the defaults for the Cache Simulator
+//
+void set_defaults();
+
+// Process an option and update the cache
+// configuration variables accordingly
+//
+// Returns True if Successful
+//
+int handle_option(char *arg);
+
+#endif
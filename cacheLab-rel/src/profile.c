@@ -0,0 +1,249 @@
+//========================================================//
+//  profile.c                                             //
+//  Source file for the miss profiler                     //
+//                                                        //
+//  Lines and regions are counted with space-saving       //
+//  sketches, whose memory does not grow with the trace   //
+//========================================================//
+
+#include "profile.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SKETCH_EMPTY 0xffffffffu
+
+//------------------------------------//
+//          Helper Functions          //
+//------------------------------------//
+
+//Function to allocate zeroed memory or bail out
+void *profileAlloc (size_t count, size_t size) {
+  void *ptr = calloc(count, size);
+  if(ptr == NULL) {
+    fprintf(stderr, "Unable to allocate the miss profiler\n");
+    exit(1);
+  }
+  return ptr;
+}
+
+//Function to get the home slot of a key in a sketch's hash table, from the
+//top bits of the product so that strided keys spread over the table
+uint32_t sketchHome (struct sketch *sk, uint32_t key) {
+  uint32_t bits = __builtin_popcount(sk->tableMask);
+  return bits ? (key * 0x9e3779b1u) >> (32 - bits) : 0;
+}
+
+//Function to swap two heap entries, keeping the table pointing at them
+void sketchSwap (struct sketch *sk, uint32_t a, uint32_t b) {
+  struct sketch_entry tmp = sk->entries[a];
+  sk->entries[a] = sk->entries[b];
+  sk->entries[b] = tmp;
+  sk->table[sk->entries[a].slot] = a;
+  sk->table[sk->entries[b].slot] = b;
+}
+
+//Function to restore the heap below entry 'k' after its count grew
+void sketchSiftDown (struct sketch *sk, uint32_t k) {
+  for(;;) {
+    uint32_t child = 2 * k + 1;
+    if(child >= sk->size) { return; }
+    if(child + 1 < sk->size && sk->entries[child + 1].count < sk->entries[child].count) { child++; }
+    if(sk->entries[k].count <= sk->entries[child].count) { return; }
+    sketchSwap(sk, k, child);
+    k = child;
+  }
+}
+
+//Function to restore the heap above entry 'k' after it was appended
+void sketchSiftUp (struct sketch *sk, uint32_t k) {
+  while(k > 0) {
+    uint32_t parent = (k - 1) / 2;
+    if(sk->entries[parent].count <= sk->entries[k].count) { return; }
+    sketchSwap(sk, k, parent);
+    k = parent;
+  }
+}
+
+//Function to remove the table slot 'slot', shifting back the entries
+//of the probe sequence behind it
+void sketchUnlink (struct sketch *sk, uint32_t slot) {
+  uint32_t next = slot;
+  sk->table[slot] = SKETCH_EMPTY;
+  for(;;) {
+    next = (next + 1) & sk->tableMask;
+    if(sk->table[next] == SKETCH_EMPTY) { return; }
+    uint32_t home = sketchHome(sk, sk->entries[sk->table[next]].key);
+    //Move the entry back unless its home lies cyclically in (slot, next]
+    if(((next - home) & sk->tableMask) >= ((next - slot) & sk->tableMask)) {
+      sk->table[slot] = sk->table[next];
+      sk->entries[sk->table[slot]].slot = slot;
+      sk->table[next] = SKETCH_EMPTY;
+      slot = next;
+    }
+  }
+}
+
+//Function to set up a sketch with 'capacity' counters
+void sketchInit (struct sketch *sk, uint32_t capacity) {
+  uint32_t tableSize = 1;
+  uint32_t k;
+  while(tableSize < 2 * capacity) { tableSize <<= 1; }
+
+  sk->entries = profileAlloc(capacity, sizeof(struct sketch_entry));
+  sk->table = profileAlloc(tableSize, sizeof(uint32_t));
+  for(k=0; k<tableSize; k++) { sk->table[k] = SKETCH_EMPTY; }
+  sk->tableMask = tableSize - 1;
+  sk->size = 0;
+  sk->capacity = capacity;
+}
+
+//Function to release a sketch
+void sketchFree (struct sketch *sk) {
+  free(sk->entries);
+  free(sk->table);
+  memset(sk, 0, sizeof(struct sketch));
+}
+
+//Function to count one occurrence of 'key'
+void sketchAdd (struct sketch *sk, uint32_t key) {
+  uint32_t slot = sketchHome(sk, key);
+  while(sk->table[slot] != SKETCH_EMPTY) {
+    uint32_t k = sk->table[slot];
+    if(sk->entries[k].key == key) {
+      sk->entries[k].count++;
+      sketchSiftDown(sk, k);
+      return;
+    }
+    slot = (slot + 1) & sk->tableMask;
+  }
+
+  if(sk->size < sk->capacity) {
+    //Room for a new counter
+    uint32_t k = sk->size++;
+    sk->entries[k].key = key;
+    sk->entries[k].slot = slot;
+    sk->entries[k].count = 1;
+    sk->entries[k].error = 0;
+    sk->table[slot] = k;
+    sketchSiftUp(sk, k);
+    return;
+  }
+
+  //Otherwise the key takes over the smallest counter, inheriting its
+  //count as the error bound
+  struct sketch_entry *min = &sk->entries[0];
+  sketchUnlink(sk, min->slot);
+  slot = sketchHome(sk, key);
+  while(sk->table[slot] != SKETCH_EMPTY) { slot = (slot + 1) & sk->tableMask; }
+  sk->table[slot] = 0;
+  min->key = key;
+  min->slot = slot;
+  min->error = min->count;
+  min->count++;
+  sketchSiftDown(sk, 0);
+}
+
+//Function to order sketch entries by decreasing count
+int compareEntries (const void *a, const void *b) {
+  const struct sketch_entry *x = a;
+  const struct sketch_entry *y = b;
+  if(x->count != y->count) { return (x->count < y->count) ? 1 : -1; }
+  return (x->key > y->key) - (x->key < y->key);
+}
+
+//Function to print the 'topK' largest counters of a sketch
+void sketchPrint (struct sketch *sk, uint32_t topK, uint32_t shift) {
+  struct sketch_entry *sorted;
+  uint32_t k;
+
+  if(sk->size == 0) {
+    printf("      -\n");
+    return;
+  }
+  sorted = profileAlloc(sk->size, sizeof(struct sketch_entry));
+  memcpy(sorted, sk->entries, sk->size * sizeof(struct sketch_entry));
+  qsort(sorted, sk->size, sizeof(struct sketch_entry), compareEntries);
+  for(k=0; k<topK && k<sk->size; k++) {
+    printf("      0x%08llx %13llu (+/- %llu)\n",
+           (unsigned long long)sorted[k].key << shift,
+           (unsigned long long)sorted[k].count,
+           (unsigned long long)sorted[k].error);
+  }
+  free(sorted);
+}
+
+//------------------------------------//
+//         Profiler Functions         //
+//------------------------------------//
+
+void profile_init(struct profile *p, uint32_t sets, uint32_t topK)
+{
+  uint32_t capacity = topK * SKETCH_SLACK;
+  sketchInit(&p->lines, capacity);
+  sketchInit(&p->victims, capacity);
+  sketchInit(&p->regions, capacity);
+  p->setEvictions = profileAlloc(sets, sizeof(uint64_t));
+  p->sets = sets;
+}
+
+void profile_free(struct profile *p)
+{
+  sketchFree(&p->lines);
+  sketchFree(&p->victims);
+  sketchFree(&p->regions);
+  free(p->setEvictions);
+  p->setEvictions = NULL;
+  p->sets = 0;
+}
+
+void profile_miss(struct profile *p, uint32_t block, uint32_t region)
+{
+  sketchAdd(&p->lines, block);
+  sketchAdd(&p->regions, region);
+}
+
+void profile_evict(struct profile *p, uint32_t block, uint32_t setIndex)
+{
+  sketchAdd(&p->victims, block);
+  //The set comes from the cache's own index function, so it is in range
+  assert(setIndex < p->sets);
+  p->setEvictions[setIndex]++;
+}
+
+void profile_print(struct profile *p, const char *name, uint32_t topK,
+                   uint32_t blockBits, uint32_t regionBits)
+{
+  uint32_t *top = profileAlloc(topK, sizeof(uint32_t));
+  uint32_t count = 0;
+  uint32_t k, s;
+
+  printf("  %s most missed lines:\n", name);
+  sketchPrint(&p->lines, topK, blockBits);
+  printf("  %s most evicted lines:\n", name);
+  sketchPrint(&p->victims, topK, blockBits);
+  printf("  %s most missed regions:\n", name);
+  sketchPrint(&p->regions, topK, regionBits);
+
+  //Keep the 'topK' sets with the most evictions, sorted, in 'top'
+  for(s=0; s<p->sets; s++) {
+    uint64_t evictions = p->setEvictions[s];
+    if(evictions == 0) { continue; }
+    if(count == topK && evictions <= p->setEvictions[top[count - 1]]) { continue; }
+    k = (count < topK) ? count++ : count - 1;
+    while(k > 0 && p->setEvictions[top[k - 1]] < evictions) {
+      top[k] = top[k - 1];
+      k--;
+    }
+    top[k] = s;
+  }
+
+  printf("  %s most conflicted sets:\n", name);
+  if(count == 0) { printf("      -\n"); }
+  for(k=0; k<count; k++) {
+    printf("      set %-9u %13llu evictions\n", top[k],
+           (unsigned long long)p->setEvictions[top[k]]);
+  }
+  free(top);
+}
@@ -0,0 +1,76 @@
+//========================================================//
+//  profile.h                                             //
+//  Header file for the miss profiler                     //
+//                                                        //
+//  Attributes the misses and evictions of a cache to     //
+//  lines, address regions and sets, with a fixed amount  //
+//  of memory per cache level                             //
+//========================================================//
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+
+//------------------------------------//
+//          Profiler Defines          //
+//------------------------------------//
+
+// Counters kept by each sketch per line of the report
+#define SKETCH_SLACK 8
+
+// Counter of the space-saving heavy-hitters sketch. 'count' over-estimates
+// the true count of 'key' by at most 'error'
+struct sketch_entry {
+  uint32_t key;
+  uint32_t slot;    // Position of the key in the hash table
+  uint64_t count;
+  uint64_t error;
+};
+
+// Space-saving sketch: a min-heap of counters on count plus an open
+// addressed hash table from key to heap position
+struct sketch {
+  struct sketch_entry *entries;
+  uint32_t *table;
+  uint32_t tableMask;
+  uint32_t size;
+  uint32_t capacity;
+};
+
+struct profile {
+  struct sketch lines;      // Misses per block
+  struct sketch victims;    // Evictions per block
+  struct sketch regions;    // Misses per address region
+  uint64_t *setEvictions;   // Evictions per set
+  uint32_t sets;
+};
+
+//------------------------------------//
+//     Profiler Function Prototypes   //
+//------------------------------------//
+
+// Set up a profiler for a cache with 'sets' sets that reports the top 'topK'
+//
+void profile_init(struct profile *p, uint32_t sets, uint32_t topK);
+
+// Release the memory of a profiler
+//
+void profile_free(struct profile *p);
+
+// Record a miss to 'block' in address region 'region'
+//
+void profile_miss(struct profile *p, uint32_t block, uint32_t region);
+
+// Record the eviction of 'block' from set 'setIndex'
+//
+void profile_evict(struct profile *p, uint32_t block, uint32_t setIndex);
+
+// Print the top 'topK' lines, regions and sets of a profiler. Blocks are
+// printed as addresses by shifting them by 'blockBits', regions by
+// 'regionBits'
+//
+void profile_print(struct profile *p, const char *name, uint32_t topK,
+                   uint32_t blockBits, uint32_t regionBits);
+
+#endif
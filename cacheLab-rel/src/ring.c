@@ -0,0 +1,238 @@
+//========================================================//
+//  ring.c                                                //
+//  Source file for the shared-memory trace ring          //
+//                                                        //
+//  Producer and consumer sides of the ring described     //
+//  in ring.h                                             //
+//========================================================//
+
+#define _GNU_SOURCE
+#include "ring.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Yields on an empty or full ring before backing off to sleeping
+#define RING_SPINS 1024
+
+//------------------------------------//
+//          Helper Functions          //
+//------------------------------------//
+
+//Function to wait a little for the other side, yielding the CPU first and
+//then sleeping so that an idle producer does not burn a core
+void ringWait (uint32_t *spins) {
+  if(++(*spins) < RING_SPINS) {
+    sched_yield();
+  } else {
+    struct timespec ts = { 0, 50000 };
+    nanosleep(&ts, NULL);
+  }
+}
+
+//Function to map a ring segment and fill in the handle
+struct ring *ringMap (const char *name, int fd, size_t size) {
+  void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if(base == MAP_FAILED) { return NULL; }
+
+  struct ring *r = calloc(1, sizeof(struct ring));
+  if(r == NULL) {
+    munmap(base, size);
+    return NULL;
+  }
+  r->hdr = base;
+  r->records = (struct ring_record *)(r->hdr + 1);
+  r->size = size;
+  r->name = strdup(name);
+  return r;
+}
+
+//Function to release a handle
+void ringUnmap (struct ring *r) {
+  munmap(r->hdr, r->size);
+  free(r->name);
+  free(r);
+}
+
+//------------------------------------//
+//         Producer Functions         //
+//------------------------------------//
+
+struct ring *ring_create(const char *name, uint32_t capacity)
+{
+  //Past the largest power of two the rounding would wrap around to 0
+  if(capacity > (1u << 31)) {
+    errno = EINVAL;
+    return NULL;
+  }
+  uint32_t cap = 1;
+  while(cap < capacity) { cap <<= 1; }
+  size_t size = sizeof(struct ring_header) + (size_t)cap * sizeof(struct ring_record);
+
+  //Start from a fresh segment so a consumer never sees a stale ring
+  shm_unlink(name);
+  int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if(fd < 0) { return NULL; }
+  if(ftruncate(fd, size) != 0) {
+    close(fd);
+    shm_unlink(name);
+    return NULL;
+  }
+
+  struct ring *r = ringMap(name, fd, size);
+  close(fd);
+  if(r == NULL) {
+    shm_unlink(name);
+    return NULL;
+  }
+
+  r->mask = cap - 1;
+  r->hdr->version = RING_VERSION;
+  r->hdr->capacity = cap;
+  r->hdr->producer = getpid();
+  //Publish the ring last, the consumer waits on the magic number
+  __atomic_store_n(&r->hdr->magic, RING_MAGIC, __ATOMIC_RELEASE);
+  return r;
+}
+
+int ring_push(struct ring *r, const struct ring_record *recs, uint32_t n)
+{
+  uint64_t head = r->hdr->head;
+  uint32_t spins = 0;
+
+  while(n) {
+    //Only re-read the consumer's index when the cached one says full
+    uint64_t room = r->hdr->capacity - (head - r->cached);
+    if(room == 0) {
+      r->cached = __atomic_load_n(&r->hdr->tail, __ATOMIC_ACQUIRE);
+      room = r->hdr->capacity - (head - r->cached);
+      if(room == 0) {
+        //Nobody will drain a ring whose consumer has gone
+        if(spins % RING_SPINS == RING_SPINS - 1) {
+          int32_t consumer = __atomic_load_n(&r->hdr->consumer, __ATOMIC_ACQUIRE);
+          if(__atomic_load_n(&r->hdr->detached, __ATOMIC_ACQUIRE)) {
+            errno = EPIPE;
+            return -1;
+          }
+          //A consumer that died never removed the ring
+          if(consumer && kill(consumer, 0) != 0 && errno == ESRCH) {
+            shm_unlink(r->name);
+            errno = EPIPE;
+            return -1;
+          }
+        }
+        ringWait(&spins);
+        continue;
+      }
+    }
+    spins = 0;
+
+    uint32_t count = (n < room) ? n : (uint32_t)room;
+    uint32_t k;
+    for(k=0; k<count; k++) {
+      r->records[(head + k) & r->mask] = recs[k];
+    }
+    head += count;
+    recs += count;
+    n -= count;
+    __atomic_store_n(&r->hdr->head, head, __ATOMIC_RELEASE);
+  }
+  return 0;
+}
+
+void ring_close(struct ring *r)
+{
+  __atomic_store_n(&r->hdr->closed, 1, __ATOMIC_RELEASE);
+  ringUnmap(r);
+}
+
+//------------------------------------//
+//         Consumer Functions         //
+//------------------------------------//
+
+struct ring *ring_attach(const char *name)
+{
+  uint32_t spins = 0;
+  int fd;
+  struct stat st;
+
+  //Wait for the producer to create and size the segment
+  for(;;) {
+    fd = shm_open(name, O_RDWR, 0);
+    if(fd >= 0) {
+      if(fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(struct ring_header)) { break; }
+      close(fd);
+    } else if(errno != ENOENT) {
+      return NULL;
+    }
+    ringWait(&spins);
+  }
+
+  struct ring *r = ringMap(name, fd, st.st_size);
+  close(fd);
+  if(r == NULL) { return NULL; }
+
+  while(__atomic_load_n(&r->hdr->magic, __ATOMIC_ACQUIRE) != RING_MAGIC) {
+    ringWait(&spins);
+  }
+  if(r->hdr->version != RING_VERSION ||
+     sizeof(struct ring_header) + (size_t)r->hdr->capacity * sizeof(struct ring_record) > r->size) {
+    ringUnmap(r);
+    errno = EINVAL;
+    return NULL;
+  }
+  r->mask = r->hdr->capacity - 1;
+  __atomic_store_n(&r->hdr->consumer, (int32_t)getpid(), __ATOMIC_RELEASE);
+  return r;
+}
+
+uint32_t ring_pop(struct ring *r, struct ring_record *recs, uint32_t max)
+{
+  uint64_t tail = r->hdr->tail;
+  uint32_t spins = 0;
+
+  //Only re-read the producer's index when the cached one says empty
+  while(r->cached == tail) {
+    r->cached = __atomic_load_n(&r->hdr->head, __ATOMIC_ACQUIRE);
+    if(r->cached != tail) { break; }
+
+    if(__atomic_load_n(&r->hdr->closed, __ATOMIC_ACQUIRE)) {
+      //The producer may have pushed its last records just before closing
+      r->cached = __atomic_load_n(&r->hdr->head, __ATOMIC_ACQUIRE);
+      if(r->cached == tail) { return 0; }
+      break;
+    }
+    //Treat a producer that died without closing as the end of the stream
+    if(spins % RING_SPINS == RING_SPINS - 1 &&
+       kill(r->hdr->producer, 0) != 0 && errno == ESRCH) {
+      fprintf(stderr, "Trace producer %d exited without closing the ring\n",
+              r->hdr->producer);
+      return 0;
+    }
+    ringWait(&spins);
+  }
+
+  uint64_t avail = r->cached - tail;
+  uint32_t count = (avail < max) ? (uint32_t)avail : max;
+  uint32_t k;
+  for(k=0; k<count; k++) {
+    recs[k] = r->records[(tail + k) & r->mask];
+  }
+  __atomic_store_n(&r->hdr->tail, tail + count, __ATOMIC_RELEASE);
+  return count;
+}
+
+void ring_detach(struct ring *r)
+{
+  __atomic_store_n(&r->hdr->detached, 1, __ATOMIC_RELEASE);
+  shm_unlink(r->name);
+  ringUnmap(r);
+}
@@ -0,0 +1,98 @@
+//========================================================//
+//  ring.h                                                //
+//  Header file for the shared-memory trace ring          //
+//                                                        //
+//  A single-producer/single-consumer ring of binary      //
+//  access records in a POSIX shared-memory segment, so   //
+//  an instrumentation tool can feed the simulator live   //
+//========================================================//
+
+#ifndef RING_H
+#define RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//------------------------------------//
+//          Ring Defines              //
+//------------------------------------//
+
+#define RING_MAGIC    0x474e4952   // "RING"
+#define RING_VERSION  2
+#define RING_DEFAULT_CAPACITY (1u << 16)
+
+// One memory access, as it would appear on a line of a text trace
+struct ring_record {
+  uint32_t addr;   // Address of the access
+  uint32_t type;   // 'I' or 'D'
+};
+
+// Layout of the start of the segment, the records follow it. The producer
+// only writes 'head' and the consumer only writes 'tail', and each sits on
+// its own cache line
+struct ring_header {
+  uint32_t magic;      // RING_MAGIC once the producer has set up the ring
+  uint32_t version;    // RING_VERSION
+  uint32_t capacity;   // Number of records, a power of two
+  uint32_t closed;     // Set by the producer after its last record
+  int32_t  producer;   // Process id of the producer
+  int32_t  consumer;   // Process id of the consumer, 0 until one attaches
+  uint32_t detached;   // Set by the consumer once it stops reading
+  char pad0[36];
+  uint64_t head;       // Records written by the producer
+  char pad1[56];
+  uint64_t tail;       // Records consumed by the consumer
+  char pad2[56];
+};
+
+// Handle on a mapped ring, private to each side
+struct ring {
+  struct ring_header *hdr;
+  struct ring_record *records;
+  uint32_t mask;
+  uint64_t cached;   // Last seen value of the other side's index
+  size_t size;       // Bytes mapped
+  char *name;
+};
+
+//------------------------------------//
+//      Producer Function Prototypes  //
+//------------------------------------//
+
+// Create the ring 'name' with room for 'capacity' records (rounded up to a
+// power of two, at most 2^31), replacing any stale ring of the same name
+// Return NULL on failure
+//
+struct ring *ring_create(const char *name, uint32_t capacity);
+
+// Append 'n' records, waiting for the consumer while the ring is full.
+// Until a consumer attaches the producer waits for one
+// Return 0 on success, -1 if the consumer detached or died, after which
+// the producer should stop and ring_close() the ring
+//
+int ring_push(struct ring *r, const struct ring_record *recs, uint32_t n);
+
+// Mark the end of the stream and release the producer's mapping
+//
+void ring_close(struct ring *r);
+
+//------------------------------------//
+//      Consumer Function Prototypes  //
+//------------------------------------//
+
+// Attach to the ring 'name', waiting for the producer to create it
+// Return NULL on failure
+//
+struct ring *ring_attach(const char *name);
+
+// Take up to 'max' records, waiting until at least one is available
+// Return the number of records taken, 0 once the stream has ended
+//
+uint32_t ring_pop(struct ring *r, struct ring_record *recs, uint32_t max);
+
+// Tell the producer the stream is no longer read, release the consumer's
+// mapping and remove the ring
+//
+void ring_detach(struct ring *r);
+
+#endif
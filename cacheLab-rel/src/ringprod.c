@@ -0,0 +1,99 @@
+//========================================================//
+//  ringprod.c                                            //
+//  Test producer for the shared-memory trace ring        //
+//                                                        //
+//  Reads a text trace and streams it into a ring for     //
+//  a simulator started with --shm=name                   //
+//========================================================//
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ring.h"
+
+#define PUSH_BATCH 1024
+
+void
+usage()
+{
+  fprintf(stderr,"Usage: ringprod <options> <name> [<trace>]\n");
+  fprintf(stderr,"       bunzip -kc trace.bz2 | ringprod <options> <name>\n");
+  fprintf(stderr," Options:\n");
+  fprintf(stderr," --help                     Print this message\n");
+  fprintf(stderr," --capacity=records         Size of the ring\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+  FILE *stream = stdin;
+  const char *name = NULL;
+  uint32_t capacity = RING_DEFAULT_CAPACITY;
+
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i],"--help")) {
+      usage();
+      exit(0);
+    } else if (!strncmp(argv[i],"--capacity=",11)) {
+      sscanf(argv[i]+11,"%u", &capacity);
+    } else if (!strncmp(argv[i],"--",2)) {
+      printf("Unrecognized option %s\n", argv[i]);
+      usage();
+      exit(1);
+    } else if (name == NULL) {
+      name = argv[i];
+    } else {
+      stream = fopen(argv[i], "r");
+      if (stream == NULL) {
+        fprintf(stderr,"Unable to open trace %s\n", argv[i]);
+        exit(1);
+      }
+    }
+  }
+  if (name == NULL) {
+    usage();
+    exit(1);
+  }
+
+  struct ring *r = ring_create(name, capacity);
+  if (r == NULL) {
+    perror("ring_create");
+    exit(1);
+  }
+
+  struct ring_record recs[PUSH_BATCH];
+  uint32_t count = 0;
+  char *buf = NULL;
+  size_t len = 0;
+  uint32_t addr;
+  char i_or_d;
+
+  int status = 0;
+
+  //Stop once the consumer has gone, nothing would drain the ring
+  while (status == 0 && getline(&buf, &len, stream) != -1) {
+    if (sscanf(buf,"0x%x %c\n",&addr,&i_or_d) != 2) {
+      continue;
+    }
+    recs[count].addr = addr;
+    recs[count].type = i_or_d;
+    if (++count == PUSH_BATCH) {
+      status = ring_push(r, recs, count);
+      count = 0;
+    }
+  }
+  if (status == 0) {
+    status = ring_push(r, recs, count);
+  }
+  if (status != 0) {
+    perror("Trace consumer has gone away");
+    status = 1;
+  }
+  ring_close(r);
+
+  fclose(stream);
+  free(buf);
+
+  return status;
+}
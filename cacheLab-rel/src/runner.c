@@ -0,0 +1,391 @@
+//========================================================//
+//  runner.c                                              //
+//  Source file for the batch runner                      //
+//                                                        //
+//  The manifest lists traces and configurations:         //
+//    trace  <name> <path>                                //
+//    config <name> <option> <option> ...                 //
+//  and every (trace, config) pair is a job.  Blank       //
+//  lines and lines starting with '#' are ignored         //
+//========================================================//
+
+#define _GNU_SOURCE
+#include "runner.h"
+#include "cache.h"
+#include "timing.h"
+#include "trace.h"
+#include "main.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+// The simulator keeps its state in globals, so jobs run in forked worker
+// processes rather than threads.  Traces are decoded by the parent in
+// waves that fit the memory limit; the workers of a wave inherit its
+// traces copy-on-write, so each decoded trace is shared read-only by every
+// job that replays it.  Each worker owns a contiguous range of the wave's
+// jobs in a deque in shared memory, takes jobs from the front of its own
+// deque and, once it runs dry, steals the back half of another's.
+
+//------------------------------------//
+//        Runner Data Structures      //
+//------------------------------------//
+
+#define MAX_TOKENS 64
+
+struct runner_trace {
+  char *name;
+  char *path;
+  struct trace trace;
+  int failed;         // The trace could not be decoded
+};
+
+struct runner_config {
+  char *name;
+  char **options;
+  uint32_t optionCount;
+};
+
+#define JOB_PENDING 0
+#define JOB_DONE    1
+
+struct job_result {
+  uint32_t status;
+  uint64_t refs;
+  uint64_t penalties;
+  uint64_t icacheRefs, icacheMisses, icachePenalties;
+  uint64_t dcacheRefs, dcacheMisses, dcachePenalties;
+  uint64_t l2cacheRefs, l2cacheMisses, l2cachePenalties;
+  uint64_t cycles;
+};
+
+// Range [lo, hi) of job indices packed as hi << 32 | lo, alone on its line
+struct deque {
+  uint64_t range;
+  char pad[56];
+};
+
+struct runner_trace *traces;
+uint32_t traceCount;
+struct runner_config *configs;
+uint32_t configCount;
+
+//Shared with the workers
+struct job_result *results;
+struct deque *deques;
+uint32_t workerCount;
+
+//Options that pick a mode of their own instead of configuring the caches,
+//which a configuration of a manifest must not use
+const char *modeOptions[] = {
+  "--batch=", "--jobs=", "--memlimit=", "--output=", "--search", "--shm=",
+  "--tenant=", "--schedule=", "--timeslice=", "--flushl1", NULL
+};
+
+//------------------------------------//
+//          Helper Functions          //
+//------------------------------------//
+
+//Function to grow an array by one element
+void *growArray (void *array, uint32_t count, size_t size) {
+  void *grown = realloc(array, (count + 1) * size);
+  if(grown == NULL) {
+    fprintf(stderr, "Out of memory reading the manifest\n");
+    exit(1);
+  }
+  return grown;
+}
+
+//Function to check whether an option picks a mode, returns TRUE if it does
+int isModeOption (const char *option) {
+  uint32_t k;
+  for(k=0; modeOptions[k]; k++) {
+    if(!strncmp(option, modeOptions[k], strlen(modeOptions[k]))) { return TRUE; }
+  }
+  return FALSE;
+}
+
+//Function to check that a name can be written into the CSV as it is
+int validName (const char *manifest, uint32_t line, const char *name) {
+  if(strpbrk(name, ",\"")) {
+    fprintf(stderr, "%s:%u: name %s may not hold ',' or '\"'\n", manifest, line, name);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+//Function to read the manifest, returns 0 on success
+int readManifest (const char *manifest) {
+  FILE *f = fopen(manifest, "r");
+  char *buf = NULL;
+  size_t len = 0;
+  uint32_t line = 0;
+  char *tokens[MAX_TOKENS];
+
+  if(f == NULL) {
+    fprintf(stderr, "Unable to open manifest %s\n", manifest);
+    return -1;
+  }
+
+  while(getline(&buf, &len, f) != -1) {
+    uint32_t n = 0;
+    char *save = NULL;
+    char *tok = strtok_r(buf, " \t\r\n", &save);
+    line++;
+    while(tok && n < MAX_TOKENS) {
+      tokens[n++] = tok;
+      tok = strtok_r(NULL, " \t\r\n", &save);
+    }
+    if(n == 0 || tokens[0][0] == '#') { continue; }
+    if(n >= 2 && !validName(manifest, line, tokens[1])) {
+      fclose(f);
+      free(buf);
+      return -1;
+    }
+
+    if(!strcmp(tokens[0], "trace") && n == 3) {
+      traces = growArray(traces, traceCount, sizeof(struct runner_trace));
+      memset(&traces[traceCount], 0, sizeof(struct runner_trace));
+      traces[traceCount].name = strdup(tokens[1]);
+      traces[traceCount].path = strdup(tokens[2]);
+      traceCount++;
+    } else if(!strcmp(tokens[0], "config") && n >= 2) {
+      struct runner_config *c;
+      uint32_t k;
+      configs = growArray(configs, configCount, sizeof(struct runner_config));
+      c = &configs[configCount++];
+      c->name = strdup(tokens[1]);
+      c->optionCount = n - 2;
+      c->options = calloc(n, sizeof(char *));
+      for(k=2; k<n; k++) {
+        c->options[k - 2] = strdup(tokens[k]);
+        //Check the options now rather than in every worker
+        set_defaults();
+        if(isModeOption(tokens[k])) {
+          fprintf(stderr, "%s:%u: option %s is not allowed in a config\n", manifest, line, tokens[k]);
+          fclose(f);
+          free(buf);
+          return -1;
+        }
+        if(strncmp(tokens[k], "--", 2) || !handle_option(c->options[k - 2])) {
+          fprintf(stderr, "%s:%u: unrecognized option %s\n", manifest, line, tokens[k]);
+          fclose(f);
+          free(buf);
+          return -1;
+        }
+      }
+    } else {
+      fprintf(stderr, "%s:%u: expected 'trace <name> <path>' or "
+                      "'config <name> <options>'\n", manifest, line);
+      fclose(f);
+      free(buf);
+      return -1;
+    }
+  }
+
+  fclose(f);
+  free(buf);
+  return 0;
+}
+
+//Function to take the next job from the front of a worker's own deque
+int popJob (uint32_t self, uint32_t *job) {
+  uint64_t cur = __atomic_load_n(&deques[self].range, __ATOMIC_ACQUIRE);
+  for(;;) {
+    uint32_t lo = (uint32_t)cur;
+    uint32_t hi = (uint32_t)(cur >> 32);
+    if(lo >= hi) { return 0; }
+    uint64_t next = ((uint64_t)hi << 32) | (lo + 1);
+    if(__atomic_compare_exchange_n(&deques[self].range, &cur, next, 0,
+                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      *job = lo;
+      return 1;
+    }
+  }
+}
+
+//Function to steal the back half of another worker's deque into an empty
+//one of our own, returning the first stolen job
+int stealJobs (uint32_t self, uint32_t *job) {
+  uint32_t k;
+  for(k=1; k<workerCount; k++) {
+    uint32_t victim = (self + k) % workerCount;
+    uint64_t cur = __atomic_load_n(&deques[victim].range, __ATOMIC_ACQUIRE);
+    for(;;) {
+      uint32_t lo = (uint32_t)cur;
+      uint32_t hi = (uint32_t)(cur >> 32);
+      if(lo >= hi) { break; }
+      uint32_t mid = hi - (hi - lo + 1) / 2;
+      uint64_t left = ((uint64_t)mid << 32) | lo;
+      if(__atomic_compare_exchange_n(&deques[victim].range, &cur, left, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        //Our deque is empty, so nobody else writes it until this store
+        __atomic_store_n(&deques[self].range, ((uint64_t)hi << 32) | (mid + 1),
+                         __ATOMIC_RELEASE);
+        *job = mid;
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+//Function to run one job and record its statistics
+void runJob (uint32_t job) {
+  struct runner_trace *t = &traces[job / configCount];
+  struct runner_config *c = &configs[job % configCount];
+  struct job_result *r = &results[job];
+  uint32_t k;
+
+  if(t->failed) { return; }
+  set_defaults();
+  for(k=0; k<c->optionCount; k++) { handle_option(c->options[k]); }
+
+  init_cache();
+  r->penalties = trace_run(&t->trace, 0, t->trace.count);
+  if(l1mshrs) {
+    timing_finish();
+    r->cycles = timingCycles;
+  }
+  r->refs = t->trace.count;
+  r->icacheRefs = icacheRefs;
+  r->icacheMisses = icacheMisses;
+  r->icachePenalties = icachePenalties;
+  r->dcacheRefs = dcacheRefs;
+  r->dcacheMisses = dcacheMisses;
+  r->dcachePenalties = dcachePenalties;
+  r->l2cacheRefs = l2cacheRefs;
+  r->l2cacheMisses = l2cacheMisses;
+  r->l2cachePenalties = l2cachePenalties;
+  free_cache();
+
+  __atomic_store_n(&r->status, JOB_DONE, __ATOMIC_RELEASE);
+}
+
+//Function to run the jobs [first, last) on the worker processes
+void runWave (uint32_t first, uint32_t last, uint32_t workers) {
+  uint32_t jobs = last - first;
+  uint32_t k;
+
+  workerCount = (workers < jobs) ? workers : jobs;
+  for(k=0; k<workerCount; k++) {
+    uint32_t lo = first + (uint64_t)jobs * k / workerCount;
+    uint32_t hi = first + (uint64_t)jobs * (k + 1) / workerCount;
+    deques[k].range = ((uint64_t)hi << 32) | lo;
+  }
+
+  fflush(NULL);
+  for(k=0; k<workerCount; k++) {
+    pid_t pid = fork();
+    if(pid < 0) {
+      perror("fork");
+      exit(1);
+    }
+    if(pid == 0) {
+      uint32_t job;
+      while(popJob(k, &job) || stealJobs(k, &job)) { runJob(job); }
+      _exit(0);
+    }
+  }
+  while(wait(NULL) > 0) { }
+}
+
+//Function to write the results of every job as CSV
+void writeResults (FILE *out) {
+  uint32_t job;
+  fprintf(out, "trace,config,status,refs,penalties,amat,"
+               "icache_refs,icache_misses,icache_penalties,"
+               "dcache_refs,dcache_misses,dcache_penalties,"
+               "l2cache_refs,l2cache_misses,l2cache_penalties,cycles\n");
+  for(job=0; job<traceCount * configCount; job++) {
+    struct job_result *r = &results[job];
+    fprintf(out, "%s,%s,", traces[job / configCount].name, configs[job % configCount].name);
+    if(r->status != JOB_DONE) {
+      fprintf(out, "failed,,,,,,,,,,,,,\n");
+      continue;
+    }
+    fprintf(out, "ok,%llu,%llu,%.4f,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu\n",
+            (unsigned long long)r->refs, (unsigned long long)r->penalties,
+            r->refs ? (double)r->penalties / r->refs : 0.0,
+            (unsigned long long)r->icacheRefs, (unsigned long long)r->icacheMisses,
+            (unsigned long long)r->icachePenalties,
+            (unsigned long long)r->dcacheRefs, (unsigned long long)r->dcacheMisses,
+            (unsigned long long)r->dcachePenalties,
+            (unsigned long long)r->l2cacheRefs, (unsigned long long)r->l2cacheMisses,
+            (unsigned long long)r->l2cachePenalties,
+            (unsigned long long)r->cycles);
+  }
+}
+
+//------------------------------------//
+//          Runner Functions          //
+//------------------------------------//
+
+int run_batch(const char *manifest, const char *output,
+              uint32_t workers, uint32_t memLimit)
+{
+  size_t limit = (size_t)memLimit << 20;
+  size_t resident = 0;
+  uint32_t waveStart = 0;
+  uint32_t t, job;
+  int status = 0;
+
+  if(readManifest(manifest) != 0) { return 1; }
+  if(traceCount == 0 || configCount == 0) {
+    fprintf(stderr, "Manifest %s has no jobs\n", manifest);
+    return 1;
+  }
+  if(workers == 0) { workers = sysconf(_SC_NPROCESSORS_ONLN); }
+  if(workers == 0) { workers = 1; }
+
+  FILE *out = output ? fopen(output, "w") : stdout;
+  if(out == NULL) {
+    fprintf(stderr, "Unable to open %s\n", output);
+    return 1;
+  }
+
+  //Job j replays trace j / configCount, so the jobs of a trace are adjacent
+  results = mmap(NULL, (size_t)traceCount * configCount * sizeof(struct job_result),
+                 PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  deques = mmap(NULL, workers * sizeof(struct deque),
+                PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if(results == MAP_FAILED || deques == MAP_FAILED) {
+    fprintf(stderr, "Unable to map the job table\n");
+    return 1;
+  }
+
+  //Decode traces until the next one would not fit, then run that wave and
+  //decode that trace again. The trace of a wave is decoded within what the
+  //wave leaves of the limit, so the traces of a wave never take more than it
+  for(t=0; t<traceCount; t++) {
+    int loaded;
+    if(t > waveStart) {
+      loaded = trace_load_limited(&traces[t].trace, traces[t].path,
+                                  (resident < limit) ? limit - resident : 0);
+      if(loaded == 1) {
+        runWave(waveStart * configCount, t * configCount, workers);
+        for(; waveStart<t; waveStart++) { trace_free(&traces[waveStart].trace); }
+        resident = 0;
+      }
+    }
+    if(t == waveStart) {
+      //A trace larger than the limit runs on its own
+      loaded = trace_load(&traces[t].trace, traces[t].path);
+    }
+    traces[t].failed = (loaded != 0);
+    resident += trace_bytes(&traces[t].trace);
+  }
+  runWave(waveStart * configCount, traceCount * configCount, workers);
+  for(; waveStart<traceCount; waveStart++) { trace_free(&traces[waveStart].trace); }
+
+  writeResults(out);
+  if(output) { fclose(out); }
+
+  for(job=0; job<traceCount * configCount; job++) {
+    if(results[job].status != JOB_DONE) { status = 1; }
+  }
+  return status;
+}
@@ -0,0 +1,23 @@
+//========================================================//
+//  runner.h                                              //
+//  Header file for the batch runner                      //
+//                                                        //
+//  Runs every trace of a manifest against every cache    //
+//  configuration of it and writes all of the results     //
+//  to one CSV file                                       //
+//========================================================//
+
+#ifndef RUNNER_H
+#define RUNNER_H
+
+#include <stdint.h>
+
+// Run the jobs of 'manifest' on 'workers' worker processes (0 for one per
+// online CPU), keeping at most 'memLimit' MiB of decoded traces resident,
+// and write the results to 'output' (stdout if NULL)
+// Return 0 if every job ran, 1 otherwise
+//
+int run_batch(const char *manifest, const char *output,
+              uint32_t workers, uint32_t memLimit);
+
+#endif
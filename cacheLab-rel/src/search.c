@@ -0,0 +1,336 @@
+//========================================================//
+//  search.c                                              //
+//  Source file for the design-space search               //
+//                                                        //
+//  Every geometry (sets x assoc) of the searched level   //
+//  is simulated once, with a hit latency of 0: each      //
+//  serial access to the level adds its hit latency once  //
+//  to the access times, so the AMAT of every allowed     //
+//  latency follows from the count of serial accesses     //
+//========================================================//
+
+#include "search.h"
+#include "cache.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+
+// Accesses simulated between two checks of whether a candidate can still
+// make it onto the frontier
+#define SEARCH_SLICE (1u << 16)
+
+// Sets and associativity of a candidate
+struct geometry {
+  uint32_t sets;
+  uint32_t assoc;
+  uint64_t size;
+};
+
+// Configuration that met the target
+struct point {
+  uint64_t size;
+  uint32_t sets;
+  uint32_t assoc;
+  uint32_t lat;
+  double amat;
+};
+
+//Configuration variables of the searched level
+uint32_t *levelSets;
+uint32_t *levelAssoc;
+uint32_t *levelHitTime;
+
+//Frontier found so far
+struct point *points;
+uint32_t pointCount;
+
+//Candidates that were simulated to the end, stopped early or never run
+uint32_t simulated;
+uint32_t stoppedEarly;
+uint32_t pruned;
+
+//------------------------------------//
+//          Helper Functions          //
+//------------------------------------//
+
+//Functions to order geometries by size and latencies and points by value
+int compareGeometry (const void *a, const void *b) {
+  const struct geometry *x = a, *y = b;
+  if(x->size != y->size) { return (x->size < y->size) ? -1 : 1; }
+  return (x->assoc < y->assoc) ? -1 : (x->assoc > y->assoc);
+}
+
+int compareValue (const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return (x < y) ? -1 : (x > y);
+}
+
+int comparePoint (const void *a, const void *b) {
+  const struct point *x = a, *y = b;
+  if(x->lat != y->lat) { return (x->lat < y->lat) ? -1 : 1; }
+  if(x->size != y->size) { return (x->size < y->size) ? -1 : 1; }
+  return (x->amat < y->amat) ? -1 : (x->amat > y->amat);
+}
+
+//Function to get the fastest an access of type 'type' can be, with the
+//searched level 'level' at hit latency 'lat'
+uint32_t minAccessTime (char type, char level, uint32_t lat) {
+  uint32_t l1Sets = (type == 'I') ? icacheSets : dcacheSets;
+  uint32_t l1Hit = (type == 'I') ? icacheHitTime : dcacheHitTime;
+
+  if(level == type) { return lat; }
+  if(l1Sets) { return l1Hit; }
+  if(level == 'L') { return lat; }
+  if(l2cacheSets) { return l2cacheHitTime; }
+  return 0;
+}
+
+//Function to get the serial accesses of the searched level so far. The L2$
+//accesses of one L1 fill go out together and add its latency only once
+uint64_t levelRefs (char level) {
+  switch(level) {
+    case 'I': return icacheRefs;
+    case 'D': return dcacheRefs;
+    default:  return l2cacheRefs - l2cacheOverlapped;
+  }
+}
+
+//Function to get the best AMAT on the frontier of latency 'lat' with no
+//larger size
+double bestAmat (uint64_t size, uint32_t lat) {
+  double best = DBL_MAX;
+  uint32_t k;
+  for(k=0; k<pointCount; k++) {
+    if(points[k].size <= size && points[k].lat == lat && points[k].amat < best) {
+      best = points[k].amat;
+    }
+  }
+  return best;
+}
+
+//Function to check whether a candidate can still meet the target and beat
+//the frontier at some latency. 'time' and 'refs' are the access time and
+//serial level accesses of the first 'done' accesses, 'doneI' of them fetches; the rest
+//are bounded by the fastest access they could be
+int stillUseful (struct search_space *space, const double *best, uint64_t total,
+                 uint64_t totalI, uint64_t done, uint64_t doneI,
+                 uint64_t time, uint64_t refs) {
+  uint64_t restI = totalI - doneI;
+  uint64_t restD = (total - done) - restI;
+  uint32_t l;
+
+  for(l=0; l<space->latCount; l++) {
+    uint32_t lat = space->lat[l];
+    double bound = (double)(time + (uint64_t)lat * refs +
+                            restI * minAccessTime('I', space->level, lat) +
+                            restD * minAccessTime('D', space->level, lat)) / total;
+    if(bound <= space->target && bound < best[l]) { return 1; }
+  }
+  return 0;
+}
+
+//------------------------------------//
+//          Search Functions          //
+//------------------------------------//
+
+int search_parse_list(const char *arg, uint32_t *values, uint32_t *count)
+{
+  const char *p = arg;
+  char *end;
+
+  *count = 0;
+  while(*p) {
+    unsigned long value = strtoul(p, &end, 10);
+    if(end == p || *count == SEARCH_MAX) { return -1; }
+    values[(*count)++] = (uint32_t)value;
+    if(*end == ',') { p = end + 1; }
+    else if(*end == '\0') { p = end; }
+    else { return -1; }
+  }
+  return *count ? 0 : -1;
+}
+
+int run_search(const char *path, struct search_space *space)
+{
+  struct trace t;
+  struct geometry *geometries;
+  uint32_t geometryCount = 0;
+  uint32_t lineSize;
+  uint32_t indexFn;
+  uint64_t totalI = 0;
+  const char *levelName;
+  double best[SEARCH_MAX];
+  uint32_t g, k, l, s, a;
+
+  if(trace_load(&t, path) != 0) { return 1; }
+  if(t.count == 0) {
+    fprintf(stderr, "Trace %s has no accesses\n", path);
+    trace_free(&t);
+    return 1;
+  }
+  for(k=0; k<t.count; k++) { totalI += (t.types[k] == 'I'); }
+
+  //Latency only adds up linearly for serialised accesses, and the shadow
+  //caches and profilers are not needed to rank configurations
+  l1mshrs = 0;
+  classify = 0;
+  profileTopK = 0;
+
+  switch(space->level) {
+    case 'I':
+      levelSets = &icacheSets; levelAssoc = &icacheAssoc; levelHitTime = &icacheHitTime;
+      lineSize = icacheBlocksize ? icacheBlocksize : blocksize;
+      indexFn = icacheIndexFn;
+      levelName = "I-cache";
+      break;
+    case 'D':
+      levelSets = &dcacheSets; levelAssoc = &dcacheAssoc; levelHitTime = &dcacheHitTime;
+      lineSize = dcacheBlocksize ? dcacheBlocksize : blocksize;
+      indexFn = dcacheIndexFn;
+      levelName = "D-cache";
+      break;
+    default:
+      levelSets = &l2cacheSets; levelAssoc = &l2cacheAssoc; levelHitTime = &l2cacheHitTime;
+      lineSize = l2cacheBlocksize ? l2cacheBlocksize : blocksize;
+      indexFn = l2cacheIndexFn;
+      levelName = "L2-cache";
+      break;
+  }
+
+  //Parameters without a list keep the value they were configured with
+  if(space->setCount == 0) { space->sets[space->setCount++] = *levelSets; }
+  if(space->assocCount == 0) { space->assoc[space->assocCount++] = *levelAssoc; }
+  if(space->latCount == 0) { space->lat[space->latCount++] = *levelHitTime; }
+  for(s=0; s<space->setCount; s++) {
+    if(!index_supports_sets(indexFn, space->sets[s])) {
+      fprintf(stderr, "%u sets is not a power of two, use the :prime index\n", space->sets[s]);
+      trace_free(&t);
+      return 1;
+    }
+  }
+
+  //Latencies in increasing order, without repeats
+  qsort(space->lat, space->latCount, sizeof(uint32_t), compareValue);
+  for(l=1, k=1; l<space->latCount; l++) {
+    if(space->lat[l] != space->lat[k - 1]) { space->lat[k++] = space->lat[l]; }
+  }
+  space->latCount = k;
+
+  //Every geometry within the budget, smallest first, so that the frontier
+  //built so far can cut the larger ones short
+  geometries = malloc((size_t)space->setCount * space->assocCount * sizeof(struct geometry));
+  points = malloc((size_t)space->setCount * space->assocCount * space->latCount * sizeof(struct point));
+  if(geometries == NULL || points == NULL) {
+    fprintf(stderr, "Unable to allocate the search\n");
+    exit(1);
+  }
+  for(s=0; s<space->setCount; s++) {
+    for(a=0; a<space->assocCount; a++) {
+      uint64_t size = (uint64_t)space->sets[s] * space->assoc[a] * lineSize;
+      if(space->sets[s] == 0 || space->assoc[a] == 0) { continue; }
+      if(space->budget && size > space->budget) { continue; }
+      geometries[geometryCount].sets = space->sets[s];
+      geometries[geometryCount].assoc = space->assoc[a];
+      geometries[geometryCount].size = size;
+      geometryCount++;
+    }
+  }
+  qsort(geometries, geometryCount, sizeof(struct geometry), compareGeometry);
+
+  pointCount = 0;
+  simulated = 0;
+  stoppedEarly = 0;
+  pruned = 0;
+
+  for(g=0; g<geometryCount; g++) {
+    struct geometry *geo = &geometries[g];
+    uint64_t time = 0, doneI = 0;
+    uint32_t done = 0;
+    int useful = 1;
+
+    for(l=0; l<space->latCount; l++) { best[l] = bestAmat(geo->size, space->lat[l]); }
+
+    //Nothing is known yet but the fastest each access could be
+    if(!stillUseful(space, best, t.count, totalI, 0, 0, 0, 0)) {
+      pruned++;
+      continue;
+    }
+
+    *levelSets = geo->sets;
+    *levelAssoc = geo->assoc;
+    *levelHitTime = 0;
+    init_cache();
+
+    while(done < t.count) {
+      uint32_t last = (t.count - done < SEARCH_SLICE) ? t.count : done + SEARCH_SLICE;
+      for(k=done; k<last; k++) { doneI += (t.types[k] == 'I'); }
+      time += trace_run(&t, done, last);
+      done = last;
+      if(done < t.count &&
+         !stillUseful(space, best, t.count, totalI, done, doneI, time, levelRefs(space->level))) {
+        useful = 0;
+        break;
+      }
+    }
+
+    uint64_t refs = levelRefs(space->level);
+    free_cache();
+    if(!useful) {
+      stoppedEarly++;
+      continue;
+    }
+    simulated++;
+
+    for(l=0; l<space->latCount; l++) {
+      double amat = (double)(time + (uint64_t)space->lat[l] * refs) / t.count;
+      if(amat <= space->target && amat < best[l]) {
+        struct point *p = &points[pointCount++];
+        p->size = geo->size;
+        p->sets = geo->sets;
+        p->assoc = geo->assoc;
+        p->lat = space->lat[l];
+        p->amat = amat;
+      }
+    }
+  }
+
+  //Print, for each latency, the points no other point of that latency
+  //matches or beats on both size and AMAT
+  qsort(points, pointCount, sizeof(struct point), comparePoint);
+  printf("Design Space Search:\n");
+  printf("  Level:         %s\n", levelName);
+  printf("  Target AMAT:   %.2f cycles\n", space->target);
+  if(space->budget) {
+    printf("  Size Budget:   %llu Bytes\n", (unsigned long long)space->budget);
+  }
+  printf("  Candidates:    %u (%u geometries x %u latencies)\n",
+         geometryCount * space->latCount, geometryCount, space->latCount);
+  printf("  Simulated:     %u\n", simulated);
+  printf("  Stopped early: %u\n", stoppedEarly);
+  printf("  Pruned:        %u\n", pruned);
+  printf("Pareto Frontier:\n");
+  printf("  %12s %8s %6s %6s %10s\n", "Size", "Sets", "Assoc", "Lat", "AMAT");
+  uint32_t shown = 0;
+  for(k=0; k<pointCount; k++) {
+    int dominated = 0;
+    for(g=0; g<k && !dominated; g++) {
+      dominated = points[g].lat == points[k].lat && points[g].size <= points[k].size &&
+                  points[g].amat <= points[k].amat;
+    }
+    if(dominated) { continue; }
+    printf("  %12llu %8u %6u %6u %10.2f\n", (unsigned long long)points[k].size,
+           points[k].sets, points[k].assoc, points[k].lat, points[k].amat);
+    shown++;
+  }
+  if(shown == 0) {
+    printf("  No configuration meets the target\n");
+  }
+
+  free(geometries);
+  free(points);
+  points = NULL;
+  trace_free(&t);
+  return 0;
+}
@@ -0,0 +1,41 @@
+//========================================================//
+//  search.h                                              //
+//  Header file for the design-space search               //
+//                                                        //
+//  Finds the configurations of one cache level that      //
+//  meet an AMAT target, and reports the Pareto frontier  //
+//  of their size against AMAT for each hit latency       //
+//========================================================//
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdint.h>
+
+// Most values allowed for each parameter of the searched level
+#define SEARCH_MAX 32
+
+struct search_space {
+  char level;                   // Level searched, 'I', 'D' or 'L' (0 for none)
+  double target;                // AMAT every reported configuration meets
+  uint64_t budget;              // Largest size of the level in bytes, 0 for any
+  uint32_t sets[SEARCH_MAX];    // Allowed numbers of sets
+  uint32_t setCount;
+  uint32_t assoc[SEARCH_MAX];   // Allowed associativities
+  uint32_t assocCount;
+  uint32_t lat[SEARCH_MAX];     // Allowed hit latencies
+  uint32_t latCount;
+};
+
+// Parse a comma separated list of at most SEARCH_MAX values
+// Return 0 on success, -1 if it is not such a list
+//
+int search_parse_list(const char *arg, uint32_t *values, uint32_t *count);
+
+// Search 'space' for the trace at 'path' with the other levels as
+// configured, and print the Pareto frontier
+// Return 0 on success, 1 if the trace cannot be loaded
+//
+int run_search(const char *path, struct search_space *space);
+
+#endif
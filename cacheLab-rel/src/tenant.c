@@ -0,0 +1,231 @@
+//========================================================//
+//  tenant.c                                              //
+//  Source file for multi-tenant runs                     //
+//                                                        //
+//  Each slice runs one tenant's trace through the batch  //
+//  interface with its way mask installed, and charges    //
+//  the change in the cache counters to that tenant       //
+//========================================================//
+
+#define _GNU_SOURCE
+#include "tenant.h"
+#include "cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//------------------------------------//
+//          Helper Functions          //
+//------------------------------------//
+
+//Function to get the ways a mask can name in the L2$
+uint32_t l2WayBits () {
+  return (l2cacheAssoc >= 32) ? 0xffffffffu : (1u << l2cacheAssoc) - 1;
+}
+
+//Function to check that every tenant is scheduled, and that each mask
+//leaves its tenant at least one L2$ way
+int checkMix (struct tenant_mix *mix) {
+  uint32_t k, s;
+
+  for(k=0; k<mix->count; k++) {
+    struct tenant *t = &mix->tenants[k];
+    if(l2cacheSets && l2cacheAssoc && t->wayMask && !(t->wayMask & l2WayBits())) {
+      fprintf(stderr, "Way mask 0x%x of tenant %u leaves it no L2-cache way\n", t->wayMask, k);
+      return -1;
+    }
+    if(mix->scheduleLength == 0) { continue; }
+    for(s=0; s<mix->scheduleLength && mix->schedule[s] != k; s++);
+    if(s == mix->scheduleLength) {
+      fprintf(stderr, "Tenant %u is not in the schedule\n", k);
+      return -1;
+    }
+  }
+  for(s=0; s<mix->scheduleLength; s++) {
+    if(mix->schedule[s] >= mix->count) {
+      fprintf(stderr, "Schedule names tenant %u of %u\n", mix->schedule[s], mix->count);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+//Function to run accesses [first, last) of tenant 't', charging it the refs,
+//misses and access time they add
+void runSlice (struct tenant *t, uint32_t first, uint32_t last) {
+  uint64_t iRefs = icacheRefs, iMisses = icacheMisses;
+  uint64_t dRefs = dcacheRefs, dMisses = dcacheMisses;
+  uint64_t l2Refs = l2cacheRefs, l2Misses = l2cacheMisses;
+
+  t->time += trace_run(&t->trace, first, last);
+  t->refs += last - first;
+  t->icacheRefs += icacheRefs - iRefs;
+  t->icacheMisses += icacheMisses - iMisses;
+  t->dcacheRefs += dcacheRefs - dRefs;
+  t->dcacheMisses += dcacheMisses - dMisses;
+  t->l2cacheRefs += l2cacheRefs - l2Refs;
+  t->l2cacheMisses += l2cacheMisses - l2Misses;
+}
+
+//------------------------------------//
+//          Tenant Functions          //
+//------------------------------------//
+
+int tenant_add(struct tenant_mix *mix, const char *arg)
+{
+  struct tenant *t;
+  const char *colon = strrchr(arg, ':');
+  char *path, *end;
+
+  if(mix->count == TENANT_MAX) { return -1; }
+  t = &mix->tenants[mix->count];
+  memset(t, 0, sizeof(struct tenant));
+
+  //A path may hold a ':' itself, only a hex number after the last one is
+  //taken as the mask
+  if(colon) {
+    unsigned long mask = strtoul(colon + 1, &end, 16);
+    if(end == colon + 1 || *end != '\0') { colon = NULL; }
+    else if(mask == 0 || mask > 0xffffffffUL) { return -1; }
+    else { t->wayMask = (uint32_t)mask; }
+  }
+
+  path = colon ? strndup(arg, colon - arg) : strdup(arg);
+  if(path == NULL || path[0] == '\0') {
+    free(path);
+    return -1;
+  }
+  t->path = path;
+  mix->count++;
+  return 0;
+}
+
+int tenant_parse_schedule(struct tenant_mix *mix, const char *arg)
+{
+  const char *p = arg;
+  char *end;
+
+  mix->scheduleLength = 0;
+  if(!strcmp(arg, "rr")) { return 0; }
+  while(*p) {
+    unsigned long value = strtoul(p, &end, 10);
+    if(end == p || mix->scheduleLength == SCHEDULE_MAX) { return -1; }
+    mix->schedule[mix->scheduleLength++] = (uint32_t)value;
+    if(*end == ',') { p = end + 1; }
+    else if(*end == '\0') { p = end; }
+    else { return -1; }
+  }
+  return mix->scheduleLength ? 0 : -1;
+}
+
+int run_tenants(struct tenant_mix *mix, uint64_t *refs, uint64_t *time)
+{
+  uint32_t length = mix->scheduleLength ? mix->scheduleLength : mix->count;
+  uint32_t current = TENANT_MAX;
+  uint32_t running = 0;
+  uint32_t slot, k;
+
+  if(mix->timeslice == 0) { mix->timeslice = TENANT_TIMESLICE; }
+  if(checkMix(mix) != 0) { return 1; }
+  for(k=0; k<mix->count; k++) {
+    if(trace_load(&mix->tenants[k].trace, mix->tenants[k].path) != 0) {
+      while(k-- > 0) { trace_free(&mix->tenants[k].trace); }
+      return 1;
+    }
+    running += (mix->tenants[k].trace.count > 0);
+  }
+
+  //Every tenant is in the schedule, so each pass over it runs at least one
+  //slice until the last trace ends
+  mix->switches = 0;
+  for(slot=0; running; slot=(slot + 1) % length) {
+    uint32_t n = mix->scheduleLength ? mix->schedule[slot] : slot;
+    struct tenant *t = &mix->tenants[n];
+    if(t->next == t->trace.count) { continue; }
+
+    if(n != current) {
+      if(current != TENANT_MAX) {
+        mix->switches++;
+        if(mix->flushL1) { flush_l1(); }
+      }
+      current = n;
+      l2cacheWayMask = t->wayMask & l2WayBits();
+    }
+
+    uint32_t last = (t->trace.count - t->next < mix->timeslice) ?
+                    t->trace.count : t->next + mix->timeslice;
+    runSlice(t, t->next, last);
+    t->next = last;
+    if(t->next == t->trace.count) { running--; }
+  }
+  l2cacheWayMask = 0;
+
+  for(k=0; k<mix->count; k++) {
+    *refs += mix->tenants[k].refs;
+    *time += mix->tenants[k].time;
+    trace_free(&mix->tenants[k].trace);
+  }
+  return 0;
+}
+
+void print_tenants(const struct tenant_mix *mix)
+{
+  uint32_t k;
+
+  printf("Tenant Statistics:\n");
+  printf("  Time Slice:  %u accesses\n", mix->timeslice);
+  if(mix->scheduleLength) {
+    printf("  Schedule:    ");
+    for(k=0; k<mix->scheduleLength; k++) {
+      printf("%s%u", k ? "," : "", mix->schedule[k]);
+    }
+    printf("\n");
+  } else {
+    printf("  Schedule:    round robin\n");
+  }
+  printf("  L1 Flush:    %s\n", mix->flushL1 ? "Yes" : "No");
+  printf("  total context switches:  %13llu\n", (unsigned long long)mix->switches);
+
+  for(k=0; k<mix->count; k++) {
+    const struct tenant *t = &mix->tenants[k];
+    printf("  Tenant %u: %s\n", k, t->path);
+    if(t->wayMask) {
+      printf("    L2 Way Mask: 0x%x\n", t->wayMask);
+    }
+    printf("    total accesses:        %13llu\n", (unsigned long long)t->refs);
+    if(icacheSets) {
+      printf("    I-cache accesses:      %13llu\n", (unsigned long long)t->icacheRefs);
+      printf("    I-cache misses:        %13llu\n", (unsigned long long)t->icacheMisses);
+    }
+    if(dcacheSets) {
+      printf("    D-cache accesses:      %13llu\n", (unsigned long long)t->dcacheRefs);
+      printf("    D-cache misses:        %13llu\n", (unsigned long long)t->dcacheMisses);
+    }
+    if(l2cacheSets) {
+      printf("    L2-cache accesses:     %13llu\n", (unsigned long long)t->l2cacheRefs);
+      printf("    L2-cache misses:       %13llu\n", (unsigned long long)t->l2cacheMisses);
+      if(t->l2cacheRefs > 0) {
+        printf("    L2-cache miss rate:%17.2f%%\n",
+               100.0 * (double)t->l2cacheMisses / t->l2cacheRefs);
+      } else {
+        printf("    L2-cache miss rate:                -\n");
+      }
+    }
+    if(t->refs > 0) {
+      printf("    avg Memory access time:%13.2f cycles\n", (double)t->time / t->refs);
+    } else {
+      printf("    avg Memory access time:            -\n");
+    }
+  }
+}
+
+void tenant_free(struct tenant_mix *mix)
+{
+  uint32_t k;
+
+  for(k=0; k<mix->count; k++) {
+    free((char *)mix->tenants[k].path);
+    mix->tenants[k].path = NULL;
+  }
+  mix->count = 0;
+}
@@ -0,0 +1,75 @@
+//========================================================//
+//  tenant.h                                              //
+//  Header file for multi-tenant runs                     //
+//                                                        //
+//  Interleaves the traces of several tenants on one      //
+//  memory hierarchy, time slice by time slice, with      //
+//  each tenant's L2 fills kept to its own ways           //
+//========================================================//
+
+#ifndef TENANT_H
+#define TENANT_H
+
+#include <stdint.h>
+#include "trace.h"
+
+// Most tenants, and most slots in a schedule
+#define TENANT_MAX   16
+#define SCHEDULE_MAX 64
+
+// Accesses a tenant runs before the next one is switched in, by default
+#define TENANT_TIMESLICE 100000
+
+struct tenant {
+  const char *path;       // Trace of the tenant
+  uint32_t wayMask;       // L2$ ways its fills may take, 0 for every way
+  struct trace trace;
+  uint32_t next;          // First access of the trace not run yet
+
+  uint64_t refs;          // Accesses of the tenant
+  uint64_t time;          // Sum of their access times
+  uint64_t icacheRefs;
+  uint64_t icacheMisses;
+  uint64_t dcacheRefs;
+  uint64_t dcacheMisses;
+  uint64_t l2cacheRefs;
+  uint64_t l2cacheMisses;
+};
+
+struct tenant_mix {
+  struct tenant tenants[TENANT_MAX];
+  uint32_t count;
+  uint32_t schedule[SCHEDULE_MAX];  // Tenants in the order they run, repeated
+  uint32_t scheduleLength;          // 0 for round robin
+  uint32_t timeslice;               // Accesses per slice, 0 for the default
+  uint32_t flushL1;                 // Flush the I$ and D$ on a context switch
+  uint64_t switches;                // Context switches taken
+};
+
+// Add the tenant described by 'arg', path[:waymask] with the mask in hex
+// Return 0 on success, -1 if there are too many tenants or the mask is bad
+//
+int tenant_add(struct tenant_mix *mix, const char *arg);
+
+// Parse a schedule, 'rr' for round robin or a comma separated list of
+// tenant numbers in the order they run
+// Return 0 on success, -1 if it is not such a schedule
+//
+int tenant_parse_schedule(struct tenant_mix *mix, const char *arg);
+
+// Load the traces of the tenants and run them through the caches, which
+// must be initialised, slice by slice until every trace has ended.  The
+// accesses and their summed access times are added to 'refs' and 'time'
+// Return 0 on success, 1 if a trace cannot be loaded or the mix is invalid
+//
+int run_tenants(struct tenant_mix *mix, uint64_t *refs, uint64_t *time);
+
+// Print the schedule and the statistics of each tenant
+//
+void print_tenants(const struct tenant_mix *mix);
+
+// Release the paths of the tenants and empty the mix
+//
+void tenant_free(struct tenant_mix *mix);
+
+#endif
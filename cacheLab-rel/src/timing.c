@@ -0,0 +1,160 @@
+//========================================================//
+//  timing.c                                              //
+//  Source file for the non-blocking timing model         //
+//                                                        //
+//  Keeps an event queue of outstanding miss completions  //
+//  and advances the core clock as the window drains      //
+//========================================================//
+
+#include "timing.h"
+#include "cache.h"
+#include "tlb.h"
+#include <stdio.h>
+
+//------------------------------------//
+//        Timing Model State          //
+//------------------------------------//
+
+uint64_t timingNow;
+uint64_t timingReady;
+
+uint64_t timingCycles;
+uint64_t timingMisses;
+uint64_t timingMissCycles;
+uint64_t timingBusyCycles;
+uint64_t timingWindowStalls;
+
+//Cycle at which the next access issues
+uint64_t coreCycle;
+//Latest completion seen so far
+uint64_t lastReady;
+//End of the last interval during which a miss was in flight
+uint64_t busyEnd;
+
+//Event queue: min-heap of outstanding miss completion cycles
+uint64_t *events;
+uint32_t eventCount;
+
+//------------------------------------//
+//          Helper Functions          //
+//------------------------------------//
+
+//Push a completion cycle onto the event queue
+void pushEvent (uint64_t ready) {
+  uint32_t k = eventCount++;
+  while(k > 0) {
+    uint32_t parent = (k - 1) / 2;
+    if(events[parent] <= ready) { break; }
+    events[k] = events[parent];
+    k = parent;
+  }
+  events[k] = ready;
+}
+
+//Pop the earliest completion cycle off the event queue
+uint64_t popEvent () {
+  uint64_t top = events[0];
+  uint64_t last = events[--eventCount];
+  uint32_t k = 0;
+  for(;;) {
+    uint32_t child = 2 * k + 1;
+    if(child >= eventCount) { break; }
+    if(child + 1 < eventCount && events[child + 1] < events[child]) { child++; }
+    if(last <= events[child]) { break; }
+    events[k] = events[child];
+    k = child;
+  }
+  if(eventCount) { events[k] = last; }
+  return top;
+}
+
+//------------------------------------//
+//          Timing Functions          //
+//------------------------------------//
+
+void init_timing()
+{
+  timingNow          = 0;
+  timingReady        = 0;
+  timingCycles       = 0;
+  timingMisses       = 0;
+  timingMissCycles   = 0;
+  timingBusyCycles   = 0;
+  timingWindowStalls = 0;
+
+  coreCycle  = 0;
+  lastReady  = 0;
+  busyEnd    = 0;
+  eventCount = 0;
+
+  if(missWindow == 0) { missWindow = 1; }
+  events = malloc(missWindow * sizeof(uint64_t));
+  if(events == NULL) {
+    fprintf(stderr, "Unable to allocate a %u entry miss window\n", missWindow);
+    exit(1);
+  }
+}
+
+void free_timing()
+{
+  free(events);
+  events = NULL;
+  eventCount = 0;
+}
+
+uint32_t timing_access(uint32_t addr, char i_or_d)
+{
+  //Retire every miss that has completed by now
+  while(eventCount && events[0] <= coreCycle) { popEvent(); }
+
+  //A full window stalls the core until the oldest miss returns
+  if(eventCount == missWindow) {
+    coreCycle = popEvent();
+    timingWindowStalls++;
+  }
+
+  uint64_t issue = coreCycle;
+  uint32_t l1HitTime;
+  uint32_t accessTime;
+
+  timingNow = issue;
+  //Translation comes first and delays the cache access on a TLB miss
+  accessTime = tlbEnabled ? tlb_translate(addr, i_or_d) : 0;
+  if(i_or_d == 'I') {
+    accessTime += icache_access(addr);
+    l1HitTime = icacheSets ? icacheHitTime : 0;
+    if(itlbEntries) { l1HitTime += itlbHitTime; }
+  } else {
+    accessTime += dcache_access(addr);
+    l1HitTime = dcacheSets ? dcacheHitTime : 0;
+    if(dtlbEntries) { l1HitTime += dtlbHitTime; }
+  }
+
+  //Anything slower than an L1 hit occupies a slot in the miss window
+  if(timingReady > issue + l1HitTime) {
+    timingMisses++;
+    timingMissCycles += timingReady - issue;
+    pushEvent(timingReady);
+
+    //Issue cycles are monotonic, so the busy intervals can be merged
+    //on the fly to count cycles with at least one miss outstanding
+    if(issue >= busyEnd) {
+      timingBusyCycles += timingReady - issue;
+      busyEnd = timingReady;
+    } else if(timingReady > busyEnd) {
+      timingBusyCycles += timingReady - busyEnd;
+      busyEnd = timingReady;
+    }
+  }
+
+  if(timingReady > lastReady) { lastReady = timingReady; }
+  coreCycle++;
+
+  return accessTime;
+}
+
+void timing_finish()
+{
+  eventCount = 0;
+  timingCycles = (lastReady > coreCycle) ? lastReady : coreCycle;
+}
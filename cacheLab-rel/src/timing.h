@@ -0,0 +1,57 @@
+//========================================================//
+//  timing.h                                              //
+//  Header file for the non-blocking timing model         //
+//                                                        //
+//  The core issues one access per cycle and may keep up  //
+//  to 'missWindow' misses in flight.  Each cache level   //
+//  tracks its in-flight lines in MSHRs (see cache.c)     //
+//========================================================//
+
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdint.h>
+
+//------------------------------------//
+//        Timing Model State          //
+//------------------------------------//
+
+// Cycle at which the current request reaches a cache level, set by the
+// caller before an access; each level writes the cycle at which the
+// requested line is available into timingReady
+//
+extern uint64_t timingNow;
+extern uint64_t timingReady;
+
+//------------------------------------//
+//        Timing Statistics           //
+//------------------------------------//
+
+extern uint64_t timingCycles;      // Effective cycles to run the trace
+extern uint64_t timingMisses;      // Accesses that left the L1
+extern uint64_t timingMissCycles;  // Sum of the latencies of those misses
+extern uint64_t timingBusyCycles;  // Cycles with at least one miss in flight
+extern uint64_t timingWindowStalls;// Issues delayed by a full miss window
+
+//------------------------------------//
+//     Timing Function Prototypes     //
+//------------------------------------//
+
+// Reset the core clock and allocate the outstanding miss queue
+//
+void init_timing();
+
+// Release the outstanding miss queue
+//
+void free_timing();
+
+// Issue an access to the I$ ('I') or D$ ('D') on the core clock
+// Return the serialised access time, as icache_access/dcache_access do
+//
+uint32_t timing_access(uint32_t addr, char i_or_d);
+
+// Drain the outstanding misses and finalise timingCycles
+//
+void timing_finish();
+
+#endif
@@ -0,0 +1,245 @@
+//========================================================//
+//  tlb.c                                                 //
+//  Source file for the address translation model         //
+//                                                        //
+//  Each TLB is set associative with LRU replacement.     //
+//  Page tables are laid out as an x86-64 style radix     //
+//  tree in a reserved region at the top of the address   //
+//  space, so walks touch realistic, shared PTE lines     //
+//========================================================//
+
+#include "tlb.h"
+#include "cache.h"
+#include "timing.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Page tables live at PT_BASE and up, one 4 KiB table of 512 PTEs per node.
+// They are not kept apart from the trace, whose addresses up there share
+// lines with them in the D$ and L2$
+#define PT_BASE    0xF0000000u
+#define PT_LEVELS  4
+
+//------------------------------------//
+//          TLB Configuration         //
+//------------------------------------//
+
+uint32_t itlbEntries;    // Number of entries in the I-TLB
+uint32_t itlbAssoc;      // Associativity of the I-TLB
+uint32_t itlbHitTime;    // Hit Time of the I-TLB
+
+uint32_t dtlbEntries;    // Number of entries in the D-TLB
+uint32_t dtlbAssoc;      // Associativity of the D-TLB
+uint32_t dtlbHitTime;    // Hit Time of the D-TLB
+
+uint32_t l2tlbEntries;   // Number of entries in the L2-TLB
+uint32_t l2tlbAssoc;     // Associativity of the L2-TLB
+uint32_t l2tlbHitTime;   // Hit Time of the L2-TLB
+
+uint32_t pagesize;       // Page size, 4 KiB, 2 MiB or 1 GiB
+
+int tlbEnabled;
+
+//------------------------------------//
+//          TLB Statistics            //
+//------------------------------------//
+
+uint64_t itlbRefs;
+uint64_t itlbMisses;
+uint64_t dtlbRefs;
+uint64_t dtlbMisses;
+uint64_t l2tlbRefs;
+uint64_t l2tlbMisses;
+uint64_t pageWalks;
+uint64_t walkRefs;
+uint64_t walkPenalties;
+uint64_t tlbPenalties;
+
+//------------------------------------//
+//        TLB Data Structures         //
+//------------------------------------//
+
+// The lru field holds the value of the TLB's clock at the last access
+struct tlb_entry {
+  uint32_t valid;
+  uint32_t vpn;
+  uint32_t lru;
+};
+
+struct tlb {
+  struct tlb_entry *entries;  // Set 'i' starts at entries[i * assoc]
+  uint32_t sets;
+  uint32_t assoc;
+  uint32_t clock;
+};
+
+struct tlb itlb;
+struct tlb dtlb;
+struct tlb l2tlb;
+
+//Bits of the page offset
+uint32_t pageBits;
+//Levels of the page table, 4 for 4 KiB pages down to 2 for 1 GiB pages
+uint32_t walkLevels;
+//Address of the first table of each level
+uint32_t levelBase[PT_LEVELS];
+
+//------------------------------------//
+//          Helper Functions          //
+//------------------------------------//
+
+//Function to look 'vpn' up in a TLB, returns TRUE on a hit
+int tlbLookup (struct tlb *t, uint32_t vpn) {
+  struct tlb_entry *set = t->entries + (size_t)(vpn % t->sets) * t->assoc;
+  uint32_t w;
+  for(w=0; w<t->assoc; w++) {
+    if(set[w].valid && set[w].vpn == vpn) {
+      set[w].lru = ++t->clock;
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+//Function to insert 'vpn' into a TLB, replacing a vacant or the LRU entry
+void tlbFill (struct tlb *t, uint32_t vpn) {
+  struct tlb_entry *set = t->entries + (size_t)(vpn % t->sets) * t->assoc;
+  struct tlb_entry *victim = &set[0];
+  uint32_t w;
+  for(w=0; w<t->assoc && victim->valid; w++) {
+    if(!set[w].valid || (int32_t)(set[w].lru - victim->lru) < 0) { victim = &set[w]; }
+  }
+  victim->valid = 1;
+  victim->vpn = vpn;
+  victim->lru = ++t->clock;
+}
+
+//Function to allocate a TLB of 'entries' entries, fully associative if
+//'assoc' is 0 or does not divide them
+void tlbInit (struct tlb *t, uint32_t entries, uint32_t assoc) {
+  if(assoc == 0 || assoc > entries || entries % assoc) { assoc = entries; }
+  t->assoc = assoc;
+  t->sets = entries / assoc;
+  t->clock = 0;
+  t->entries = calloc(entries, sizeof(struct tlb_entry));
+  if(t->entries == NULL) {
+    fprintf(stderr, "Unable to allocate the TLBs\n");
+    exit(1);
+  }
+}
+
+//Function to walk the page table for 'addr', one dependent D$ access per
+//level. Returns the cycles the walk took
+uint32_t pageWalk (uint32_t addr) {
+  uint64_t va = addr;
+  uint32_t total = 0;
+  uint32_t k;
+
+  pageWalks++;
+  for(k=0; k<walkLevels; k++) {
+    //Level k covers 9 bits of the address above those of the level below
+    uint32_t span = pageBits + 9 * (walkLevels - k);
+    uint32_t table = (uint32_t)(va >> span);
+    uint32_t index = (uint32_t)(va >> (span - 9)) & 511;
+    uint32_t time = dcache_access(levelBase[k] + table * 4096 + index * 8);
+    walkRefs++;
+    total += time;
+    //The next level needs the PTE this one returns
+    if(l1mshrs) { timingNow = timingReady; }
+  }
+  walkPenalties += total;
+  return total;
+}
+
+//------------------------------------//
+//           TLB Functions            //
+//------------------------------------//
+
+void init_tlb()
+{
+  uint32_t k, offset;
+
+  itlbRefs      = 0;
+  itlbMisses    = 0;
+  dtlbRefs      = 0;
+  dtlbMisses    = 0;
+  l2tlbRefs     = 0;
+  l2tlbMisses   = 0;
+  pageWalks     = 0;
+  walkRefs      = 0;
+  walkPenalties = 0;
+  tlbPenalties  = 0;
+
+  tlbEnabled = itlbEntries || dtlbEntries || l2tlbEntries;
+  if(!tlbEnabled) { return; }
+
+  if(itlbEntries) { tlbInit(&itlb, itlbEntries, itlbAssoc); }
+  if(dtlbEntries) { tlbInit(&dtlb, dtlbEntries, dtlbAssoc); }
+  if(l2tlbEntries) { tlbInit(&l2tlb, l2tlbEntries, l2tlbAssoc); }
+
+  //Each level below the root resolves 9 more bits, 2 MiB and 1 GiB pages
+  //end the walk one and two levels early
+  for(pageBits=12; pageBits<30 && (1u << pageBits) < pagesize; pageBits++);
+  walkLevels = PT_LEVELS - (pageBits - 12) / 9;
+
+  //Lay the tables of each level out back to back, as many as it takes to
+  //map the 32-bit address space
+  offset = 0;
+  for(k=0; k<walkLevels; k++) {
+    uint32_t span = pageBits + 9 * (walkLevels - k);
+    levelBase[k] = PT_BASE + offset;
+    offset += (span >= 32 ? 1u : 1u << (32 - span)) * 4096;
+  }
+}
+
+void free_tlb()
+{
+  free(itlb.entries);
+  free(dtlb.entries);
+  free(l2tlb.entries);
+  itlb.entries = dtlb.entries = l2tlb.entries = NULL;
+  tlbEnabled = 0;
+}
+
+uint32_t tlb_translate(uint32_t addr, char i_or_d)
+{
+  uint32_t vpn = addr >> pageBits;
+  struct tlb *l1 = (i_or_d == 'I') ? &itlb : &dtlb;
+  uint32_t l1Entries = (i_or_d == 'I') ? itlbEntries : dtlbEntries;
+  uint32_t l1HitTime = l1Entries ? ((i_or_d == 'I') ? itlbHitTime : dtlbHitTime) : 0;
+  uint32_t time = l1HitTime;
+
+  //With no TLB at all on this side the translation is ideal
+  if(!l1Entries && !l2tlbEntries) { return 0; }
+
+  //Check the L1 TLB
+  if(l1Entries) {
+    if(i_or_d == 'I') { itlbRefs++; } else { dtlbRefs++; }
+    if(tlbLookup(l1, vpn)) {
+      timingNow += time;
+      return time;
+    }
+    if(i_or_d == 'I') { itlbMisses++; } else { dtlbMisses++; }
+  }
+
+  //Then the L2 TLB, and walk the page table if it misses as well
+  int walk = TRUE;
+  if(l2tlbEntries) {
+    l2tlbRefs++;
+    time += l2tlbHitTime;
+    if(tlbLookup(&l2tlb, vpn)) {
+      walk = FALSE;
+    } else {
+      l2tlbMisses++;
+    }
+  }
+  timingNow += time;
+  if(walk) {
+    time += pageWalk(addr);
+    if(l2tlbEntries) { tlbFill(&l2tlb, vpn); }
+  }
+  if(l1Entries) { tlbFill(l1, vpn); }
+
+  tlbPenalties += time - l1HitTime;
+  return time;
+}
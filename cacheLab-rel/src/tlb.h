@@ -0,0 +1,73 @@
+//========================================================//
+//  tlb.h                                                 //
+//  Header file for the address translation model         //
+//                                                        //
+//  I-TLB and D-TLB backed by a shared L2-TLB, and a      //
+//  radix page walk whose page table accesses go to the   //
+//  data-cache hierarchy                                  //
+//========================================================//
+
+#ifndef TLB_H
+#define TLB_H
+
+#include <stdint.h>
+
+//------------------------------------//
+//          TLB Configuration         //
+//------------------------------------//
+
+extern uint32_t itlbEntries;    // Number of entries in the I-TLB
+extern uint32_t itlbAssoc;      // Associativity of the I-TLB
+extern uint32_t itlbHitTime;    // Hit Time of the I-TLB
+
+extern uint32_t dtlbEntries;    // Number of entries in the D-TLB
+extern uint32_t dtlbAssoc;      // Associativity of the D-TLB
+extern uint32_t dtlbHitTime;    // Hit Time of the D-TLB
+
+extern uint32_t l2tlbEntries;   // Number of entries in the L2-TLB
+extern uint32_t l2tlbAssoc;     // Associativity of the L2-TLB
+extern uint32_t l2tlbHitTime;   // Hit Time of the L2-TLB
+
+extern uint32_t pagesize;       // Page size, 4 KiB, 2 MiB or 1 GiB
+
+// Addresses are translated, set by init_tlb() when any TLB is configured
+//
+extern int tlbEnabled;
+
+//------------------------------------//
+//          TLB Statistics            //
+//------------------------------------//
+
+extern uint64_t itlbRefs;       // I-TLB references
+extern uint64_t itlbMisses;     // I-TLB misses
+extern uint64_t dtlbRefs;       // D-TLB references
+extern uint64_t dtlbMisses;     // D-TLB misses
+extern uint64_t l2tlbRefs;      // L2-TLB references
+extern uint64_t l2tlbMisses;    // L2-TLB misses
+extern uint64_t pageWalks;      // Page walks
+extern uint64_t walkRefs;       // Page table accesses sent to the D$
+extern uint64_t walkPenalties;  // Cycles spent walking the page table
+extern uint64_t tlbPenalties;   // Translation cycles beyond an L1 TLB hit
+
+//------------------------------------//
+//      TLB Function Prototypes       //
+//------------------------------------//
+
+// Reset the TLB statistics and allocate the TLBs
+//
+void init_tlb();
+
+// Release the memory held by the TLBs
+//
+void free_tlb();
+
+// Translate the address 'addr' of an instruction ('I') or data ('D')
+// access, walking the page table through the D$ on a TLB miss
+// An access whose L1 TLB and the L2-TLB are both missing is translated
+// for free, as if by an ideal TLB
+// Return the translation time; with the timing model timingNow is moved
+// to the cycle at which the translation is known
+//
+uint32_t tlb_translate(uint32_t addr, char i_or_d);
+
+#endif
@@ -0,0 +1,149 @@
+//========================================================//
+//  trace.c                                               //
+//  Source file for in-memory traces                      //
+//                                                        //
+//  Decodes text traces, plain or bzip2 compressed, and   //
+//  replays them through the batch access interface       //
+//========================================================//
+
+#define _GNU_SOURCE
+#include "trace.h"
+#include "cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Accesses handed to the caches per batch when replaying a trace
+#define TRACE_CHUNK 4096
+
+//------------------------------------//
+//          Helper Functions          //
+//------------------------------------//
+
+//Function to open a trace, through bzip2 if it is compressed
+FILE *traceOpen (const char *path, int *piped) {
+  size_t len = strlen(path);
+  *piped = (len > 4 && !strcmp(path + len - 4, ".bz2"));
+  if(!*piped) { return fopen(path, "r"); }
+
+  //Single quote the path for the shell, escaping any quotes inside it
+  char *cmd = malloc(4 * len + 32);
+  char *out = cmd + sprintf(cmd, "bzip2 -dc '");
+  const char *in;
+  for(in=path; *in; in++) {
+    if(*in == '\'') { out += sprintf(out, "'\\''"); } else { *out++ = *in; }
+  }
+  sprintf(out, "'");
+  FILE *f = popen(cmd, "r");
+  free(cmd);
+  return f;
+}
+
+//Function to make room for one more access, within 'maxBytes' bytes.
+//Returns 1 if that would take more, -1 if the memory is not there
+int traceGrow (struct trace *t, size_t maxBytes) {
+  uint32_t capacity = t->capacity ? t->capacity * 2 : (1u << 16);
+  if((size_t)capacity * (sizeof(uint32_t) + sizeof(char)) > maxBytes) { return 1; }
+  uint32_t *addrs = realloc(t->addrs, (size_t)capacity * sizeof(uint32_t));
+  if(addrs == NULL) { return -1; }
+  t->addrs = addrs;
+  char *types = realloc(t->types, capacity);
+  if(types == NULL) { return -1; }
+  t->types = types;
+  t->capacity = capacity;
+  return 0;
+}
+
+//------------------------------------//
+//          Trace Functions           //
+//------------------------------------//
+
+int trace_load(struct trace *t, const char *path)
+{
+  return trace_load_limited(t, path, SIZE_MAX);
+}
+
+int trace_load_limited(struct trace *t, const char *path, size_t maxBytes)
+{
+  int piped;
+  FILE *f = traceOpen(path, &piped);
+  char *buf = NULL;
+  size_t len = 0;
+  uint32_t addr;
+  char i_or_d;
+  int status = 0;
+
+  memset(t, 0, sizeof(struct trace));
+  if(f == NULL) {
+    fprintf(stderr, "Unable to open trace %s\n", path);
+    return -1;
+  }
+
+  while(getline(&buf, &len, f) != -1) {
+    if(sscanf(buf, "0x%x %c", &addr, &i_or_d) != 2) { continue; }
+    if(i_or_d != 'I' && i_or_d != 'D') {
+      fprintf(stderr, "Input Error '%c' must be either 'I' or 'D' in %s\n", i_or_d, path);
+      status = -1;
+      break;
+    }
+    if(t->count == t->capacity && (status = traceGrow(t, maxBytes)) != 0) {
+      if(status < 0) { fprintf(stderr, "Unable to hold trace %s in memory\n", path); }
+      break;
+    }
+    t->addrs[t->count] = addr;
+    t->types[t->count] = i_or_d;
+    t->count++;
+  }
+  free(buf);
+
+  if(piped) {
+    //Stopping early kills bzip2 with SIGPIPE, only a full read is checked
+    if(pclose(f) != 0 && status == 0) {
+      fprintf(stderr, "Unable to decompress trace %s\n", path);
+      status = -1;
+    }
+  } else {
+    fclose(f);
+  }
+
+  if(status != 0) {
+    trace_free(t);
+    return status;
+  }
+
+  //Give back the slack of the last doubling, the trace stays resident
+  if(t->count && t->count < t->capacity) {
+    uint32_t *addrs = realloc(t->addrs, (size_t)t->count * sizeof(uint32_t));
+    char *types = realloc(t->types, t->count);
+    if(addrs) { t->addrs = addrs; }
+    if(types) { t->types = types; }
+    if(addrs && types) { t->capacity = t->count; }
+  }
+  return 0;
+}
+
+void trace_free(struct trace *t)
+{
+  free(t->addrs);
+  free(t->types);
+  memset(t, 0, sizeof(struct trace));
+}
+
+size_t trace_bytes(const struct trace *t)
+{
+  return (size_t)t->capacity * (sizeof(uint32_t) + sizeof(char));
+}
+
+uint64_t trace_run(const struct trace *t, uint32_t first, uint32_t last)
+{
+  uint32_t times[TRACE_CHUNK];
+  uint64_t total = 0;
+  uint32_t base, k;
+
+  for(base=first; base<last; base+=TRACE_CHUNK) {
+    uint32_t n = (last - base < TRACE_CHUNK) ? last - base : TRACE_CHUNK;
+    cache_access_batch(t->addrs + base, t->types + base, times, n);
+    for(k=0; k<n; k++) { total += times[k]; }
+  }
+  return total;
+}
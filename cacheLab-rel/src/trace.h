@@ -0,0 +1,53 @@
+//========================================================//
+//  trace.h                                               //
+//  Header file for in-memory traces                      //
+//                                                        //
+//  A trace decoded once into arrays of addresses and     //
+//  I/D directions, so that it can be replayed through    //
+//  many cache configurations                             //
+//========================================================//
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct trace {
+  uint32_t *addrs;   // Address of each access
+  char *types;       // 'I' or 'D' for each access
+  uint32_t count;    // Number of accesses
+  uint32_t capacity; // Room in the arrays
+};
+
+//------------------------------------//
+//       Trace Function Prototypes    //
+//------------------------------------//
+
+// Decode the text trace at 'path' into 't'. Traces ending in .bz2 are
+// decompressed on the fly
+// Return 0 on success, -1 on failure after printing why
+//
+int trace_load(struct trace *t, const char *path);
+
+// Decode the text trace at 'path' into 't' as trace_load does, unless its
+// arrays would need more than 'maxBytes' bytes
+// Return 0 on success, -1 on failure after printing why, 1 if the trace is
+// too large, leaving 't' empty
+//
+int trace_load_limited(struct trace *t, const char *path, size_t maxBytes);
+
+// Release the memory of a trace
+//
+void trace_free(struct trace *t);
+
+// Bytes of memory held by a trace
+//
+size_t trace_bytes(const struct trace *t);
+
+// Replay accesses [first, last) of a trace through the caches
+// Return the sum of their access times
+//
+uint64_t trace_run(const struct trace *t, uint32_t first, uint32_t last);
+
+#endif